@@ -0,0 +1,153 @@
+/*!
+ * @file DriftWatchdog.cpp
+ *
+ * Configuration drift watchdog for PI3EQX12908 redrivers.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "DriftWatchdog.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates an empty watchdog
+*/
+/**************************************************************************/
+DriftWatchdog::DriftWatchdog()
+  : _count(0), _next(0), _period(WATCHDOG_DEFAULT_PERIOD), _last(0), _cb(NULL), _arg(NULL),
+    _checks(0), _read_failures(0), _events(0){
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a redriver to the watchdog
+    @param  device
+            An initialized redriver.
+    @param  image
+            Expected image of registers #POWER_DOWN_REG to
+            #SIGNAL_DET_TH_REG, kept by the caller.
+    @return false if the watchdog is full or image is NULL.
+*/
+/**************************************************************************/
+bool DriftWatchdog::add(PI3EQX12908& device, const uint8_t* image){
+  if(_count >= FLEET_MAX_DEVICES || !image)
+    return false;
+  _devices[_count] = &device;
+  _device_events[_count] = 0;
+  _last_mask[_count] = 0;
+  setExpected(_count++, image);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds every redriver of a fleet to the watchdog
+    @param  fleet
+            The fleet; redrivers added to it later are not watched.
+    @param  image
+            Expected image of all of them, see add().
+*/
+/**************************************************************************/
+void DriftWatchdog::add(RedriverFleet& fleet, const uint8_t* image){
+  for(uint8_t i=0; i<fleet.size(); i++)
+    add(fleet[i], image);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the expected image of a redriver
+    @param  index
+            Index of the redriver, in the order it was added.
+    @param  image
+            #SHADOW_LEN bytes kept by the caller; NULL is ignored.
+*/
+/**************************************************************************/
+void DriftWatchdog::setExpected(uint8_t index, const uint8_t* image){
+  if(index >= _count || !image)
+    return;
+  _images[index] = image;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets how often each redriver is checked
+    @param  ms
+            Time between two checks of the same redriver. With n
+            redrivers one check is made every ms / n milliseconds.
+*/
+/**************************************************************************/
+void DriftWatchdog::setPeriod(uint32_t ms){
+  _period = ms ? ms : 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks the next redriver when its turn has come
+    @return true if a redriver was checked.
+*/
+/**************************************************************************/
+bool DriftWatchdog::update(){
+  if(!_count)
+    return false;
+  uint32_t slot = _period / _count;
+  if(millis() - _last < (slot ? slot : 1))
+    return false;
+  _last = millis();
+  uint8_t index = _next;
+  _next = (_next + 1) % _count;
+  check(index);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Checks one redriver now and repairs it if needed
+    @param  index
+            Index of the redriver, in the order it was added.
+    @return One of the DRIFT_* results.
+*/
+/**************************************************************************/
+uint8_t DriftWatchdog::check(uint8_t index){
+  if(index >= _count)
+    return DRIFT_READ_FAILED;
+  PI3EQX12908& rd = *_devices[index];
+  if(rd._in_txn)
+    return DRIFT_BUSY;
+
+  uint8_t data[REG_COUNT];
+  _checks++;
+  if(rd._bus_read(0, data, REG_COUNT) != BUS_OK){
+    _read_failures++;
+    return DRIFT_READ_FAILED;
+  }
+  uint8_t* chip = &data[SHADOW_FIRST_REG];
+
+  uint8_t expected[SHADOW_LEN];
+  memcpy(expected, _images[index], SHADOW_LEN);
+  if(!memcmp(chip, expected, SHADOW_LEN))
+    return DRIFT_NONE;
+
+  uint16_t mask = 0;
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    if(chip[i] != expected[i])
+      mask |= REG_BIT(SHADOW_FIRST_REG + i);
+  // The cache follows what was just read, the writes below bring it to the expected image
+  if(rd._cache_enabled){
+    memcpy(rd._shadow, chip, SHADOW_LEN);
+    rd._shadow_valid = true;
+  }
+  uint8_t count;
+  uint8_t result = rd._write_runs(mask, expected, count) == BUS_OK ? DRIFT_HEALED : DRIFT_HEAL_FAILED;
+
+  _events++;
+  if(_device_events[index] < 0xFFFF)
+    _device_events[index]++;
+  _last_mask[index] = mask;
+  if(_cb)
+    _cb(index, mask, result, _arg);
+  return result;
+}
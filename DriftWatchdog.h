@@ -0,0 +1,88 @@
+/*!
+ * @file DriftWatchdog.h
+ *
+ * Watchdog that finds PI3EQX12908 redrivers whose configuration no
+ * longer matches the expected one (after a brownout or a reset of the
+ * chip) and rewrites the registers that differ.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _DRIFT_WATCHDOG_H
+#define _DRIFT_WATCHDOG_H
+
+#include "PI3EQX12908A2.h"
+#include "RedriverFleet.h"
+
+#define DRIFT_NONE         0 ///< The chip matches the expected image
+#define DRIFT_HEALED       1 ///< Registers differed and were rewritten
+#define DRIFT_HEAL_FAILED  2 ///< Registers differed and rewriting them failed
+#define DRIFT_READ_FAILED  3 ///< The chip could not be read
+#define DRIFT_BUSY         4 ///< A transaction is open on the redriver, not checked
+
+#define WATCHDOG_DEFAULT_PERIOD 1000 ///< Time in ms between two checks of the same redriver
+
+/**************************************************************************/
+/*!
+    @brief  Class that verifies and repairs the writable registers
+            Each check is one read of registers 0 to #SIGNAL_DET_TH_REG,
+            past the shadow cache. The writable part is compared with
+            the expected image; on a mismatch the differing registers
+            are rewritten with the write planner of PI3EQX12908::apply().
+
+            The expected image of a redriver is a #SHADOW_LEN byte image
+            owned by the caller, e.g. RedriverProfile::image or one taken
+            with PI3EQX12908::readImage() once the redriver is set up.
+            Change the image (or call setExpected()) whenever the
+            redriver is reconfigured on purpose. The driver's shadow
+            cache is not used: it is reloaded from the chip by reads, so
+            after a reset of the chip it would hold the drifted values.
+
+            Call update() from loop(). The redrivers are checked in turn,
+            one per period / size() ms, so each of them is checked once
+            per period and the bus load stays flat.
+*/
+/**************************************************************************/
+class DriftWatchdog{
+  public:
+    /*! @brief Drift callback: index of the redriver, registers that differed (#REG_BIT mask) and the DRIFT_* result */
+    typedef void (*Callback)(uint8_t index, uint16_t mask, uint8_t result, void* arg);
+
+    DriftWatchdog();
+
+    bool add(PI3EQX12908& device, const uint8_t* image);
+    void add(RedriverFleet& fleet, const uint8_t* image);
+    void setExpected(uint8_t index, const uint8_t* image);
+    void setPeriod(uint32_t ms);
+    void setCallback(Callback cb, void* arg = NULL) { _cb = cb; _arg = arg; } ///< Called after every drift
+    uint8_t size() const { return _count; } ///< Number of watched redrivers
+
+    bool update();
+    uint8_t check(uint8_t index);
+
+    uint32_t checks() const { return _checks; }                                    ///< Checks done so far
+    uint32_t readFailures() const { return _read_failures; }                       ///< Checks that could not read the chip
+    uint32_t driftEvents() const { return _events; }                               ///< Drifts found on all redrivers
+    uint16_t driftEvents(uint8_t index) const { return _device_events[index]; }    ///< Drifts found on one redriver
+    uint16_t lastDriftMask(uint8_t index) const { return _last_mask[index]; }      ///< Registers that differed on the last drift of a redriver
+
+  private:
+    PI3EQX12908*   _devices[FLEET_MAX_DEVICES];
+    const uint8_t* _images[FLEET_MAX_DEVICES];
+    uint16_t       _device_events[FLEET_MAX_DEVICES];
+    uint16_t       _last_mask[FLEET_MAX_DEVICES];
+    uint8_t        _count;
+    uint8_t        _next;
+    uint32_t       _period;
+    unsigned long  _last;
+    Callback       _cb;
+    void*          _arg;
+    uint32_t       _checks;
+    uint32_t       _read_failures;
+    uint32_t       _events;
+};
+
+#endif
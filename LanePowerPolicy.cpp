@@ -0,0 +1,174 @@
+/*!
+ * @file LanePowerPolicy.cpp
+ *
+ * Opt-in automatic power down of unconnected PI3EQX12908 lanes.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "LanePowerPolicy.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates an inactive policy for a redriver
+    @param  rd
+            An initialized redriver.
+*/
+/**************************************************************************/
+LanePowerPolicy::LanePowerPolicy(PI3EQX12908& rd)
+  : _rd(&rd), _lanes(0), _down(0), _down_samples(POLICY_DEFAULT_DOWN_SAMPLES),
+    _up_samples(POLICY_DEFAULT_UP_SAMPLES), _lane_mw(0), _last(0){
+  for(uint8_t i=0; i<8; i++){
+    _count[i] = 0;
+    _off_ms[i] = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Puts lanes under control of the policy
+            Lanes start in their current power state; lanes that are
+            already powered down count as powered down by the policy.
+    @param  lanes
+            Bit mask of the controlled lanes.
+    @return #BUS_OK, or the BUS_* status of the failed read of the
+            power down register; no lane is controlled then.
+*/
+/**************************************************************************/
+uint8_t LanePowerPolicy::begin(uint8_t lanes){
+  uint8_t data[REG_COUNT];
+  uint8_t status = _rd->read(REG_BIT(POWER_DOWN_REG), data);
+  // Without the current power state the first update could toggle lanes wrongly
+  _lanes = status == BUS_OK ? lanes : 0;
+  _down = status == BUS_OK ? data[POWER_DOWN_REG] & lanes : 0;
+  for(uint8_t i=0; i<8; i++)
+    _count[i] = 0;
+  _last = millis();
+  return status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Releases all lanes and powers up the ones the policy
+            turned off
+*/
+/**************************************************************************/
+void LanePowerPolicy::end(){
+  _account();
+  if(_down)
+    _rd->setPowerDownMask(_down, CFG_ON);
+  _down = 0;
+  _lanes = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the hysteresis of the policy
+    @param  down_samples
+            Consecutive samples without a receiver before a lane is
+            powered down.
+    @param  up_samples
+            Consecutive samples with a receiver before a lane is
+            powered up again.
+*/
+/**************************************************************************/
+void LanePowerPolicy::setHysteresis(uint8_t down_samples, uint8_t up_samples){
+  _down_samples = down_samples ? down_samples : 1;
+  _up_samples = up_samples ? up_samples : 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads RX detect and applies the policy
+            A failed read would look like no receiver on any lane, so
+            that cycle is skipped.
+    @return Bit mask of the lanes whose power state changed.
+*/
+/**************************************************************************/
+uint8_t LanePowerPolicy::update(){
+  uint8_t data[REG_COUNT];
+  if(_rd->read(REG_BIT(RX_DETECT_REG), data) != BUS_OK)
+    return 0;
+  return apply(data[RX_DETECT_REG]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Applies the policy to an RX detect value
+            Use this to feed the policy from a LinkMonitor instead of
+            reading the register again.
+    @param  rx_detect
+            Value of the RX detect register.
+    @return Bit mask of the lanes whose power state changed. If the
+            power down register cannot be updated nothing changes and
+            the lanes are tried again on the next sample.
+*/
+/**************************************************************************/
+uint8_t LanePowerPolicy::apply(uint8_t rx_detect){
+  uint8_t changed = 0;
+  _account();
+  for(uint8_t i=0; i<8; i++){
+    uint8_t bit = 1 << i;
+    if(!(_lanes & bit))
+      continue;
+    // A lane moves towards the other state only while RX detect disagrees with it
+    bool want_down = !(rx_detect & bit);
+    bool is_down = _down & bit;
+    if(want_down == is_down){
+      _count[i] = 0;
+      continue;
+    }
+    uint8_t needed = want_down ? _down_samples : _up_samples;
+    if(_count[i] < needed)
+      _count[i]++;
+    if(_count[i] >= needed)
+      changed |= bit;
+  }
+  if(!changed)
+    return 0;
+  // Only the changed lanes are written; a failed read leaves the register alone
+  if(_rd->_update_reg(POWER_DOWN_REG, changed, _down ^ changed) != BUS_OK)
+    return 0;
+  _down ^= changed;
+  for(uint8_t i=0; i<8; i++)
+    if(changed & (1 << i))
+      _count[i] = 0;
+  return changed;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the total lane-off time
+    @return Sum of the powered down time of all lanes in ms.
+*/
+/**************************************************************************/
+uint32_t LanePowerPolicy::totalOffMillis() const{
+  uint32_t total = 0;
+  for(uint8_t i=0; i<8; i++)
+    total += _off_ms[i];
+  return total;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Estimates the energy saved by the policy
+    @return totalOffMillis() times the lane power set with
+            setLanePower(), in mJ.
+*/
+/**************************************************************************/
+uint32_t LanePowerPolicy::energySaved_mJ() const{
+  return (uint64_t)totalOffMillis() * _lane_mw / 1000;
+}
+
+void LanePowerPolicy::_account(){
+  unsigned long now = millis();
+  unsigned long elapsed = now - _last;
+  _last = now;
+  for(uint8_t i=0; i<8; i++)
+    if(_down & (1 << i))
+      _off_ms[i] += elapsed;
+}
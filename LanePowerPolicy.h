@@ -0,0 +1,60 @@
+/*!
+ * @file LanePowerPolicy.h
+ *
+ * Opt-in policy that powers down PI3EQX12908 lanes with no far-end
+ * receiver and powers them back up when one shows up.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _LANE_POWER_POLICY_H
+#define _LANE_POWER_POLICY_H
+
+#include "PI3EQX12908A2.h"
+
+#define POLICY_DEFAULT_DOWN_SAMPLES 3 ///< Samples without a receiver before a lane is powered down
+#define POLICY_DEFAULT_UP_SAMPLES   1 ///< Samples with a receiver before a lane is powered up
+
+/**************************************************************************/
+/*! 
+    @brief  Class that drives POWER_DOWN_REG from RX_DETECT_REG
+            Lanes are the register bits (A0..A3 = 4..7, B0..B3 = 0..3).
+            All lane changes of one sample are written in a single
+            power down register update. The policy relies on the chip
+            reporting RX detect on powered down lanes.
+*/
+/**************************************************************************/
+class LanePowerPolicy{
+  public:
+    LanePowerPolicy(PI3EQX12908& rd);
+
+    uint8_t begin(uint8_t lanes = 0xFF);
+    void end();
+    void setHysteresis(uint8_t down_samples, uint8_t up_samples);
+    void setLanePower(uint16_t mw) { _lane_mw = mw; }
+    uint8_t update();
+    uint8_t apply(uint8_t rx_detect);
+
+    uint8_t poweredDown() const { return _down; }                     ///< Lanes powered down by the policy
+    uint32_t laneOffMillis(uint8_t lane) const { return _off_ms[lane]; } ///< Time a lane spent powered down
+    uint32_t totalOffMillis() const;
+    uint32_t energySaved_mJ() const;
+
+  private:
+    PI3EQX12908*  _rd;
+    uint8_t       _lanes;
+    uint8_t       _down;
+    uint8_t       _down_samples;
+    uint8_t       _up_samples;
+    uint8_t       _count[8];
+    uint16_t      _lane_mw;
+    uint32_t      _off_ms[8];
+    unsigned long _last;
+
+    void _account();
+};
+
+#endif
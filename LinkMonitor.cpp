@@ -0,0 +1,133 @@
+/*!
+ * @file LinkMonitor.cpp
+ *
+ * Debounced link monitor for a PI3EQX12908.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "LinkMonitor.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates a monitor for a redriver
+    @param  rd
+            An initialized redriver.
+*/
+/**************************************************************************/
+LinkMonitor::LinkMonitor(PI3EQX12908& rd)
+  : _rd(&rd), _cb(NULL), _arg(NULL), _debounce(LINK_DEFAULT_DEBOUNCE),
+    _min_interval(LINK_DEFAULT_MIN_INTERVAL), _max_interval(LINK_DEFAULT_MAX_INTERVAL),
+    _interval(LINK_DEFAULT_MIN_INTERVAL), _last(0), _samples(0), _errors(0), _primed(false){
+  _stable[0] = _stable[1] = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts monitoring
+            Takes the current register values as the initial state
+            without raising callbacks. If they cannot be read, the first
+            successful sample does that instead.
+    @param  cb
+            Optional transition callback.
+    @param  arg
+            Argument passed to the callback.
+*/
+/**************************************************************************/
+void LinkMonitor::begin(Callback cb, void* arg){
+  uint8_t data[REG_COUNT];
+  _cb = cb;
+  _arg = arg;
+  _samples++;
+  _primed = _rd->read(REG_BIT(SIGNAL_DETECT_REG) | REG_BIT(RX_DETECT_REG), data) == BUS_OK;
+  if(!_primed)
+    _errors++;
+  _stable[LINK_SIGNAL_DETECT] = data[SIGNAL_DETECT_REG];
+  _stable[LINK_RX_DETECT] = data[RX_DETECT_REG];
+  for(uint8_t k=0; k<2; k++)
+    for(uint8_t i=0; i<8; i++)
+      _count[k][i] = 0;
+  _interval = _min_interval;
+  _last = millis();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the bounds of the adaptive poll interval
+    @param  min_ms
+            Interval while any lane is changing.
+    @param  max_ms
+            Longest interval when all lanes are stable.
+*/
+/**************************************************************************/
+void LinkMonitor::setInterval(uint16_t min_ms, uint16_t max_ms){
+  _min_interval = min_ms ? min_ms : 1;
+  _max_interval = max_ms < _min_interval ? _min_interval : max_ms;
+  _interval = _min_interval;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Samples the link state when the poll interval has elapsed
+    @return true if the registers were read.
+*/
+/**************************************************************************/
+bool LinkMonitor::update(){
+  if(millis() - _last < _interval)
+    return false;
+  return sample();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Samples the link state now
+            Reads both detect registers in one transaction, runs the
+            debouncer and adapts the poll interval.
+    @return false if the read failed; the sample is then dropped.
+*/
+/**************************************************************************/
+bool LinkMonitor::sample(){
+  uint8_t data[REG_COUNT];
+  bool changing = false;
+  uint8_t status = _rd->read(REG_BIT(SIGNAL_DETECT_REG) | REG_BIT(RX_DETECT_REG), data);
+  _last = millis();
+  _samples++;
+  // A failed read returns zeros, which would look like every link going down
+  if(status != BUS_OK){
+    _errors++;
+    return false;
+  }
+  if(!_primed){
+    _primed = true;
+    _stable[LINK_SIGNAL_DETECT] = data[SIGNAL_DETECT_REG];
+    _stable[LINK_RX_DETECT] = data[RX_DETECT_REG];
+    return true;
+  }
+
+  for(uint8_t k=0; k<2; k++){
+    uint8_t diff = data[k] ^ _stable[k];
+    for(uint8_t i=0; i<8; i++){
+      if(!(diff & (1 << i))){
+        _count[k][i] = 0;
+        continue;
+      }
+      changing = true;
+      if(++_count[k][i] < _debounce)
+        continue;
+      _count[k][i] = 0;
+      _stable[k] ^= 1 << i;
+      if(_cb)
+        _cb(k, i, _stable[k] & (1 << i), _arg);
+    }
+  }
+
+  if(changing)
+    _interval = _min_interval;
+  else if(_interval < _max_interval)
+    _interval = (uint32_t)_interval * 2 > _max_interval ? _max_interval : _interval * 2;
+  return true;
+}
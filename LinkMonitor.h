@@ -0,0 +1,73 @@
+/*!
+ * @file LinkMonitor.h
+ *
+ * Debounced link monitor for the signal detect and RX detect registers
+ * of a PI3EQX12908, with an adaptive poll interval.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _LINK_MONITOR_H
+#define _LINK_MONITOR_H
+
+#include "PI3EQX12908A2.h"
+
+#define LINK_SIGNAL_DETECT  0 ///< Event from the signal detect register
+#define LINK_RX_DETECT      1 ///< Event from the RX detect register
+
+#define LINK_DEFAULT_DEBOUNCE     3     ///< Samples a new level must hold before it is reported
+#define LINK_DEFAULT_MIN_INTERVAL 10    ///< Poll interval in ms while a lane is changing
+#define LINK_DEFAULT_MAX_INTERVAL 1000  ///< Longest poll interval in ms when all lanes are stable
+
+/**************************************************************************/
+/*! 
+    @brief  Class that watches the link state of one redriver
+            Call update() from loop(). Registers 0 and 1 are read in one
+            2-byte transaction; a lane change is reported once it has been
+            seen on debounce consecutive samples. The poll interval drops to
+            the minimum while any lane is changing and doubles on every
+            quiet sample up to the maximum. A sample whose read fails is
+            counted in errors() and changes neither the lane state nor
+            the poll interval.
+*/
+/**************************************************************************/
+class LinkMonitor{
+  public:
+    /*! @brief Transition callback: kind is LINK_SIGNAL_DETECT or LINK_RX_DETECT,
+               lane is the register bit (A0..A3 = 4..7, B0..B3 = 0..3) */
+    typedef void (*Callback)(uint8_t kind, uint8_t lane, bool state, void* arg);
+
+    LinkMonitor(PI3EQX12908& rd);
+
+    void begin(Callback cb = NULL, void* arg = NULL);
+    void setDebounce(uint8_t samples) { _debounce = samples ? samples : 1; }
+    void setInterval(uint16_t min_ms, uint16_t max_ms);
+    bool update();
+    bool sample();
+
+    uint8_t getSignalDetect() const { return _stable[LINK_SIGNAL_DETECT]; }  ///< Debounced signal detect bitmap
+    uint8_t getRxDetect() const { return _stable[LINK_RX_DETECT]; }          ///< Debounced RX detect bitmap
+    uint16_t interval() const { return _interval; }                          ///< Current poll interval in ms
+    uint32_t samples() const { return _samples; }                            ///< Number of register reads so far
+    uint32_t errors() const { return _errors; }                              ///< Number of register reads that failed
+
+  private:
+    PI3EQX12908*  _rd;
+    Callback      _cb;
+    void*         _arg;
+    uint8_t       _stable[2];
+    uint8_t       _count[2][8];
+    uint8_t       _debounce;
+    uint16_t      _min_interval;
+    uint16_t      _max_interval;
+    uint16_t      _interval;
+    unsigned long _last;
+    uint32_t      _samples;
+    uint32_t      _errors;
+    bool          _primed;
+};
+
+#endif
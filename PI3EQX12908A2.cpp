@@ -20,35 +20,499 @@
  */
 
 #include "PI3EQX12908A2.h"
+#include "RedriverProfile.h"
+#include "RedriverFormat.h"
+#include "RedriverInstrument.h"
 #include "Arduino.h"
 
+#define REG_NAME_SIZE 14
+
+static const char _REG_NAMES[REG_DUMP_LEN][REG_NAME_SIZE] PROGMEM = {
+  "SIGNAL DETECT",
+  "    RX DETECT",
+  "   POWER DOWN",
+  "   CHANNEL A0",
+  "   CHANNEL A1",
+  "   CHANNEL A2",
+  "   CHANNEL A3",
+  "   CHANNEL B0",
+  "   CHANNEL B1",
+  "   CHANNEL B2",
+  "   CHANNEL B3",
+  "  SIG DET CFG",
+  "   RX DET CFG",
+  "  SIG DET THR",
+  "    14th BYTE",
+  "    15th BYTE"
+};
+
+#ifdef PI3EQX12908_WIRE_BUS
+static PI3EQX12908_WireBus _default_bus;
+#endif
+
+#ifdef PI3EQX12908_WIRE_BUS
+/**************************************************************************/
+/*!
+    @brief  Initialize the PI3EQX12908 object on the default Wire bus
+            This function sets the I2C address and the register names.
+    @param    i2c_addr
+              The 7 bit I2C address of the redriver.
+    @param    use_cache
+              Keep a shadow copy of the writable registers (2 to 13).
+              When enabled, the shadow is filled here with a single
+              read and setters do not read the chip back before writing.
+*/
+/**************************************************************************/
+void PI3EQX12908::init(uint8_t i2c_addr, bool use_cache){
+  init(i2c_addr, _default_bus, use_cache);
+}
+#endif
+
 /**************************************************************************/
 /*!
-    @brief  Initialize the PI3EQX12908 object
-            This function sets the I2C address and the register names.
+    @brief  Initialize the PI3EQX12908 object on a given bus
+            This function sets the I2C address and the bus transport.
     @param    i2c_addr
               The 7 bit I2C address of the redriver.
+    @param    bus
+              The transport the redriver is connected to
+              (e.g. PI3EQX12908_WireBus for Wire1). It must outlive
+              this object.
+    @param    use_cache
+              Keep a shadow copy of the writable registers (2 to 13).
 */
 /**************************************************************************/
-PI3EQX12908::init(uint8_t i2c_addr){
+void PI3EQX12908::init(uint8_t i2c_addr, PI3EQX12908_BUS& bus, bool use_cache){
+  INSTRUMENT_API("init");
   _I2C_ADDR = i2c_addr;
+  _bus = &bus;
+  _cache_enabled = use_cache;
+  _shadow_valid = false;
+  _in_txn = false;
+  _dirty = 0;
+  _rx_pending = 0;
+  _retries = DEFAULT_RETRIES;
+  _backoff_us = DEFAULT_BACKOFF_US;
+  resetErrors();
+
+  if(_cache_enabled)
+    resync();
+}
+
+// Shadow cache
+/**************************************************************************/
+/*!
+    @brief  Enables or disables the shadow cache
+            While enabled, reads of the writable registers (2 to 13)
+            are answered from the shadow and every write goes through
+            to both the chip and the shadow. The signal detect and RX
+            detect registers are always read from the chip.
+    @param  enable
+            true to enable the cache, false to disable it.
+*/
+/**************************************************************************/
+void PI3EQX12908::setCache(bool enable){
+  INSTRUMENT_API("setCache");
+  _cache_enabled = enable;
+  _shadow_valid = false;
+  if(_cache_enabled)
+    resync();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reloads the shadow cache from the chip
+            This function reads registers 0 to 13 in a single transaction
+            and refreshes the shadow of the writable registers. Inside a
+            transaction the registers changed since beginTransaction()
+            keep their pending value.
+*/
+/**************************************************************************/
+void PI3EQX12908::resync(){
+  INSTRUMENT_API("resync");
+  uint8_t data[SHADOW_LAST_REG + 1];
+  _shadow_valid = false;
+  if(_bus_read(0, data, SHADOW_LAST_REG + 1) != BUS_OK)
+    return;
+  _load_shadow(&data[SHADOW_FIRST_REG]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Invalidates the shadow cache
+            Use this when the chip may have changed behind the library
+            (reset, power cycle, another master). The shadow is reloaded
+            by the next access that needs it.
+*/
+/**************************************************************************/
+void PI3EQX12908::invalidate(){
+  _shadow_valid = false;
+}
+
+// Error handling
+/**************************************************************************/
+/*!
+    @brief  Sets the retry policy of bus accesses
+            A failed access is repeated up to retries times, waiting
+            backoff_us before the first retry and twice as long before
+            each further one. A timeout or bus error runs recover()
+            before the retry. The worst case of one access is thus
+            bounded by (retries + 1) transport timeouts plus the backoff.
+    @param  retries
+            Number of retries, 0 to give up at the first error.
+    @param  backoff_us
+            Delay before the first retry in us.
+*/
+/**************************************************************************/
+void PI3EQX12908::setRetry(uint8_t retries, uint16_t backoff_us){
+  _retries = retries;
+  _backoff_us = backoff_us;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Frees a stuck bus
+            Asks the transport to clock out a device holding SDA low and
+            to send a STOP. The shadow cache is reloaded on next use.
+    @return true if the transport recovered the bus.
+*/
+/**************************************************************************/
+bool PI3EQX12908::recover(){
+  INSTRUMENT_API("recover");
+  _shadow_valid = false;
+  return _bus->recover();
+}
+
+// Transaction
+/**************************************************************************/
+/*!
+    @brief  Starts a deferred-commit transaction
+            Until commit() is called, setters only update the shadow
+            registers and mark them dirty; nothing is written to the chip.
+            The shadow is loaded first if it is not valid yet.
+*/
+/**************************************************************************/
+void PI3EQX12908::beginTransaction(){
+  INSTRUMENT_API("beginTransaction");
+  if(_in_txn)
+    return;
+  if(!_shadow_valid)
+    resync();
+  _in_txn = true;
+  _dirty = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes all registers changed since beginTransaction()
+            Each run of dirty registers between #POWER_DOWN_REG and
+            #SIGNAL_DET_TH_REG is sent with one burst write; runs apart
+            by up to #WRITE_MERGE_GAP clean registers share a burst.
+    @return Number of I2C write transactions issued.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::commit(){
+  INSTRUMENT_API("commit");
+  uint8_t count = 0;
+  if(!_in_txn)
+    return 0;
+  // Merged runs rewrite clean registers from the shadow, reload it if it
+  // was invalidated during the transaction. If that fails the clean
+  // registers are unknown and only the dirty ones are written.
+  if(!_shadow_valid)
+    resync();
+  _in_txn = false;
+  uint8_t status = _write_runs(_dirty, _shadow, count, _shadow_valid ? WRITE_MERGE_GAP : 0);
+  _dirty = 0;
+  // Without the cache nothing keeps the shadow in step with the chip
+  if(!_cache_enabled || status != BUS_OK)
+    _shadow_valid = false;
+  return count;
+}
+
+// Read planner
+/**************************************************************************/
+/*!
+    @brief  Prefetches a set of registers with one read
+            The chip always answers reads from register 0, so this
+            function issues a single read up to the highest requested
+            register. The next getter call for each requested register
+            is answered from that buffer instead of the bus; after that
+            the register is read from the chip again as usual. Writes in
+            between update the buffer, a failed write drops it.
+    @param  mask
+            Set of registers to prefetch, built with #REG_BIT
+            (e.g. REG_BIT(CONFIG_A0_REG) | REG_BIT(SIGNAL_DET_TH_REG)).
+*/
+/**************************************************************************/
+void PI3EQX12908::prefetch(uint16_t mask){
+  INSTRUMENT_API("prefetch");
+  mask &= (uint16_t)(REG_BIT(REG_COUNT) - 1);
+  if(!mask)
+    return;
+  uint8_t top = REG_COUNT - 1;
+  while(!(mask & REG_BIT(top)))
+    top--;
+  _rx_pending = 0;
+  _burst_read(0, _rx, top + 1);
+  _rx_pending = mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a set of registers with one read
+            Like prefetch(), but the values are returned to the caller.
+            Registers held by the shadow cache are served without bus
+            access; everything else costs at most one read.
+    @param  mask
+            Set of registers to read, built with #REG_BIT.
+    @param  data
+            A pointer to an array of #REG_COUNT bytes, indexed by
+            register address. The entries from the lowest to the highest
+            requested register are written.
+    @return #BUS_OK or the BUS_* code of the failed read; the entries
+            are zero then.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::read(uint16_t mask, uint8_t* data){
+  INSTRUMENT_API("read");
+  mask &= (uint16_t)(REG_BIT(REG_COUNT) - 1);
+  if(!mask)
+    return BUS_OK;
+  uint8_t low = 0;
+  while(!(mask & REG_BIT(low)))
+    low++;
+  uint8_t top = REG_COUNT - 1;
+  while(!(mask & REG_BIT(top)))
+    top--;
+  return _burst_read(low, &data[low], top - low + 1);
+}
+
+// Channel handles
+/**************************************************************************/
+/*!
+    @brief  Gets a handle to a channel chosen at runtime
+            Use channel<BANK_A, 0>() instead when the channel is known
+            at compile time.
+    @param  bank
+            #BANK_A or #BANK_B.
+    @param  index
+            Channel index from 0 to 3.
+    @return Handle to the channel.
+*/
+/**************************************************************************/
+ChannelRef PI3EQX12908::channel(uint8_t bank, uint8_t index){
+  return ChannelRef(*this, bank, index);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the configuration register of the channel
+    @return 8 bit value of the channel config register.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getConfig(){
+  INSTRUMENT_API("ChannelRef::getConfig");
+  return _rd->_read_reg(_reg);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the equalizer index of the channel
+    @return 4 bit value of the equalizer.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getEQ(){
+  INSTRUMENT_API("ChannelRef::getEQ");
+  return (_rd->_read_reg(_reg) & EQ_MASK) >> EQ_SHIFT;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the flat gain of the channel
+    @return 2 bit value of the flat gain (#FLAT_GAIN_M4db ... #FLAT_GAIN_P2db).
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getFlatGain(){
+  INSTRUMENT_API("ChannelRef::getFlatGain");
+  return (_rd->_read_reg(_reg) & FG_MASK) >> FG_SHIFT;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the swing of the channel
+    @return 1 bit value of the swing (#SWING_900mVpp or #SWING_1000mVpp).
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getSW(){
+  INSTRUMENT_API("ChannelRef::getSW");
+  return (_rd->_read_reg(_reg) & SW_MASK) >> SW_SHIFT;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the configuration register of the channel
+            ** NOT RECOMENDED TO USE! **
+    @param  config
+            8 bit value of the config register
+*/
+/**************************************************************************/
+void ChannelRef::setConfig(uint8_t config){
+  INSTRUMENT_API("ChannelRef::setConfig");
+  _rd->_write_reg(_reg, config);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fluent update with the equalizer index
+            e.g. ch.eq(5).gain(FLAT_GAIN_00db).swing(SWING_900mVpp);
+            writes the config register once.
+    @param  EQ
+            4 bit value of the equalizer index
+    @return Pending update, written at the end of the statement.
+*/
+/**************************************************************************/
+ChannelUpdate ChannelRef::eq(uint8_t EQ){
+  ChannelUpdate update(*_rd, _reg);
+  update.eq(EQ);
+  return update;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fluent update with the flat gain
+    @param  flat_gain
+            2 bit value of the flat gain (#FLAT_GAIN_M4db ... #FLAT_GAIN_P2db).
+    @return Pending update, written at the end of the statement.
+*/
+/**************************************************************************/
+ChannelUpdate ChannelRef::gain(uint8_t flat_gain){
+  ChannelUpdate update(*_rd, _reg);
+  update.gain(flat_gain);
+  return update;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts a fluent update with the swing
+    @param  swing
+            1 bit value of the swing (#SWING_900mVpp or #SWING_1000mVpp).
+    @return Pending update, written at the end of the statement.
+*/
+/**************************************************************************/
+ChannelUpdate ChannelRef::swing(uint8_t swing){
+  ChannelUpdate update(*_rd, _reg);
+  update.swing(swing);
+  return update;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the signal detect status of the channel
+    @return zero for not detected, otherwise for detected.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getSignalDetect(){
+  INSTRUMENT_API("ChannelRef::getSignalDetect");
+  return _rd->_read_reg(SIGNAL_DETECT_REG) & _mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the RX detect status of the channel
+    @return zero for not detected, otherwise for detected.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getRxDetect(){
+  INSTRUMENT_API("ChannelRef::getRxDetect");
+  return _rd->_read_reg(RX_DETECT_REG) & _mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the power down status of the channel
+    @return zero for powered up, otherwise for powered down.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getPowerDown(){
+  INSTRUMENT_API("ChannelRef::getPowerDown");
+  return _rd->_read_reg(POWER_DOWN_REG) & _mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the signal detect configuration of the channel
+    @return zero for off, otherwise for on.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getSignalDetectConfig(){
+  INSTRUMENT_API("ChannelRef::getSignalDetectConfig");
+  return _rd->_read_reg(SIGNAL_DET_CFG_REG) & _mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the RX detect configuration of the channel
+    @return zero for off, otherwise for on.
+*/
+/**************************************************************************/
+uint8_t ChannelRef::getRxDetectConfig(){
+  INSTRUMENT_API("ChannelRef::getRxDetectConfig");
+  return _rd->_read_reg(RX_DET_CFG_REG) & _mask;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the power down of the channel
+    @param  isDown
+            - #CFG_ON  for power up
+            - #CFG_OFF for power down
+*/
+/**************************************************************************/
+void ChannelRef::setPowerDown(uint8_t isDown){
+  INSTRUMENT_API("ChannelRef::setPowerDown");
+  _rd->_update_reg(POWER_DOWN_REG, _mask, isDown ? 0xFF : 0x00);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the signal detect configuration of the channel
+    @param  isDown
+            - #CFG_ON
+            - #CFG_OFF
+*/
+/**************************************************************************/
+void ChannelRef::setSignalDetectConfig(uint8_t isDown){
+  INSTRUMENT_API("ChannelRef::setSignalDetectConfig");
+  _rd->_update_reg(SIGNAL_DET_CFG_REG, _mask, isDown ? 0xFF : 0x00);
+}
 
-  _REGS[0]  = "SIGNAL DETECT";
-  _REGS[1]  = "    RX DETECT";
-  _REGS[2]  = "   POWER DOWN";
-  _REGS[3]  = "   CHANNEL A0";
-  _REGS[4]  = "   CHANNEL A1";
-  _REGS[5]  = "   CHANNEL A2";
-  _REGS[6]  = "   CHANNEL A3";
-  _REGS[7]  = "   CHANNEL B0";
-  _REGS[8]  = "   CHANNEL B1";
-  _REGS[9]  = "   CHANNEL B2";
-  _REGS[10] = "   CHANNEL B3";
-  _REGS[11] = "  SIG DET CFG";
-  _REGS[12] = "   RX DET CFG";
-  _REGS[13] = "  SIG DET THR";
-  _REGS[14] = "    14th BYTE";
-  _REGS[15] = "    15th BYTE";
+/**************************************************************************/
+/*!
+    @brief  Sets the RX detect configuration of the channel
+    @param  isDown
+            - #CFG_ON
+            - #CFG_OFF
+*/
+/**************************************************************************/
+void ChannelRef::setRxDetectConfig(uint8_t isDown){
+  INSTRUMENT_API("ChannelRef::setRxDetectConfig");
+  _rd->_update_reg(RX_DET_CFG_REG, _mask, isDown ? 0xFF : 0x00);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the pending changes
+            All chained fields go out in one register write; fields that
+            were not set keep their current value.
+*/
+/**************************************************************************/
+void ChannelUpdate::apply(){
+  INSTRUMENT_API("ChannelUpdate::apply");
+  if(!_mask)
+    return;
+  _rd->_update_reg(_reg, _mask, _value);
+  _mask = 0;
 }
 
 // 0 - Signal Detect
@@ -60,6 +524,7 @@ PI3EQX12908::init(uint8_t i2c_addr){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetect(){
+  INSTRUMENT_API("getSignalDetect");
   return _read_reg(SIGNAL_DETECT_REG);
 }
 
@@ -72,7 +537,8 @@ uint8_t PI3EQX12908::getSignalDetect(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetect_A(){
-  return _read_reg(SIGNAL_DETECT_REG) >> 4;
+  INSTRUMENT_API("getSignalDetect_A");
+  return get<FIELD_SIGNAL_DETECT_A>();
 }
 
 /**************************************************************************/
@@ -86,6 +552,7 @@ uint8_t PI3EQX12908::getSignalDetect_A(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetect_A(uint8_t index){
+  INSTRUMENT_API("getSignalDetect_A(index)");
   return _read_reg(SIGNAL_DETECT_REG) & (1 << (index + 4));
 }
 
@@ -98,7 +565,8 @@ uint8_t PI3EQX12908::getSignalDetect_A(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetect_B(){
-  return _read_reg(SIGNAL_DETECT_REG) & 0x0F;
+  INSTRUMENT_API("getSignalDetect_B");
+  return get<FIELD_SIGNAL_DETECT_B>();
 }
 
 /**************************************************************************/
@@ -112,6 +580,7 @@ uint8_t PI3EQX12908::getSignalDetect_B(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetect_B(uint8_t index){
+  INSTRUMENT_API("getSignalDetect_B(index)");
   return _read_reg(SIGNAL_DETECT_REG) & (1 << index);
 }
 
@@ -124,6 +593,7 @@ uint8_t PI3EQX12908::getSignalDetect_B(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetect(){
+  INSTRUMENT_API("getRxDetect");
   return _read_reg(RX_DETECT_REG);
 }
 
@@ -136,7 +606,8 @@ uint8_t PI3EQX12908::getRxDetect(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetect_A(){
-  return _read_reg(RX_DETECT_REG) >> 4;
+  INSTRUMENT_API("getRxDetect_A");
+  return get<FIELD_RX_DETECT_A>();
 }
 
 /**************************************************************************/
@@ -150,6 +621,7 @@ uint8_t PI3EQX12908::getRxDetect_A(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetect_A(uint8_t index){
+  INSTRUMENT_API("getRxDetect_A(index)");
   return _read_reg(RX_DETECT_REG) & (1 << (index + 4));
 }
 
@@ -162,7 +634,8 @@ uint8_t PI3EQX12908::getRxDetect_A(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetect_B(){
-  return _read_reg(RX_DETECT_REG) & 0x0F;
+  INSTRUMENT_API("getRxDetect_B");
+  return get<FIELD_RX_DETECT_B>();
 }
 
 /**************************************************************************/
@@ -176,6 +649,7 @@ uint8_t PI3EQX12908::getRxDetect_B(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetect_B(uint8_t index){
+  INSTRUMENT_API("getRxDetect_B(index)");
   return _read_reg(RX_DETECT_REG) & (1 << index);
 }
 
@@ -188,6 +662,7 @@ uint8_t PI3EQX12908::getRxDetect_B(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getPowerDown(){
+  INSTRUMENT_API("getPowerDown");
   return _read_reg(POWER_DOWN_REG);
 }
 
@@ -200,7 +675,8 @@ uint8_t PI3EQX12908::getPowerDown(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getPowerDown_A(){
-  return _read_reg(POWER_DOWN_REG) >> 4;
+  INSTRUMENT_API("getPowerDown_A");
+  return get<FIELD_POWER_DOWN_A>();
 }
 
 /**************************************************************************/
@@ -214,6 +690,7 @@ uint8_t PI3EQX12908::getPowerDown_A(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getPowerDown_A(uint8_t index){
+  INSTRUMENT_API("getPowerDown_A(index)");
   return _read_reg(POWER_DOWN_REG) & (1 << (index + 4));
 }
 
@@ -226,7 +703,8 @@ uint8_t PI3EQX12908::getPowerDown_A(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getPowerDown_B(){
-  return _read_reg(POWER_DOWN_REG) & 0x0F;
+  INSTRUMENT_API("getPowerDown_B");
+  return get<FIELD_POWER_DOWN_B>();
 }
 
 /**************************************************************************/
@@ -240,6 +718,7 @@ uint8_t PI3EQX12908::getPowerDown_B(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getPowerDown_B(uint8_t index){
+  INSTRUMENT_API("getPowerDown_B(index)");
   return _read_reg(POWER_DOWN_REG) & (1 << index);
 }
 
@@ -253,6 +732,7 @@ uint8_t PI3EQX12908::getPowerDown_B(uint8_t index){
 */
 /**************************************************************************/
 void PI3EQX12908::setPowerDown(uint8_t isDown){
+  INSTRUMENT_API("setPowerDown");
   _write_reg(POWER_DOWN_REG, isDown ? 0xFF : 0x00);
 }
 
@@ -266,12 +746,8 @@ void PI3EQX12908::setPowerDown(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setPowerDown_A(uint8_t isDown){
-  uint8_t val = getPowerDown();
-  if(isDown)
-    val |= (uint8_t)0xF0;
-  else
-    val &= (uint8_t)0x0F;
-  _write_reg(POWER_DOWN_REG, val);
+  INSTRUMENT_API("setPowerDown_A");
+  set<FIELD_POWER_DOWN_A>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -287,12 +763,8 @@ void PI3EQX12908::setPowerDown_A(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setPowerDown_A(uint8_t index, uint8_t isDown){
-  uint8_t val = getPowerDown();
-  if(isDown)
-    val |= (1 << (index + 4));
-  else
-    val &= ~(1 << (index + 4));
-  _write_reg(POWER_DOWN_REG, val);
+  INSTRUMENT_API("setPowerDown_A(index)");
+  _update_reg(POWER_DOWN_REG, 1 << (index + 4), isDown ? 0xFF : 0x00);
 }
 
 /**************************************************************************/
@@ -305,12 +777,8 @@ void PI3EQX12908::setPowerDown_A(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setPowerDown_B(uint8_t isDown){
-  uint8_t val = getPowerDown();
-  if(isDown)
-    val |= (uint8_t)0x0F;
-  else
-    val &= (uint8_t)0xF0;
-  _write_reg(POWER_DOWN_REG, val);
+  INSTRUMENT_API("setPowerDown_B");
+  set<FIELD_POWER_DOWN_B>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -326,12 +794,8 @@ void PI3EQX12908::setPowerDown_B(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setPowerDown_B(uint8_t index, uint8_t isDown){
-  uint8_t val = getPowerDown();
-  if(isDown)
-    val |= (1 << index);
-  else
-    val &= ~(1 << index);
-  _write_reg(POWER_DOWN_REG, val);
+  INSTRUMENT_API("setPowerDown_B(index)");
+  _update_reg(POWER_DOWN_REG, 1 << index, isDown ? 0xFF : 0x00);
 }
 
 // 3 - A0 Config
@@ -343,6 +807,7 @@ void PI3EQX12908::setPowerDown_B(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_A0(){
+  INSTRUMENT_API("getConfig_A0");
   return _read_reg(CONFIG_A0_REG);
 }
 
@@ -354,7 +819,8 @@ uint8_t PI3EQX12908::getConfig_A0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_A0(){
-  return _read_reg(CONFIG_A0_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_A0");
+  return get<FIELD_EQ_A0>();
 }
 
 /**************************************************************************/
@@ -369,7 +835,8 @@ uint8_t PI3EQX12908::getEQ_A0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_A0(){
-  return (_read_reg(CONFIG_A0_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_A0");
+  return get<FIELD_FG_A0>();
 }
 
 /**************************************************************************/
@@ -382,7 +849,8 @@ uint8_t PI3EQX12908::getFlatGain_A0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_A0(){
-  return _read_reg(CONFIG_A0_REG) & 0x01;
+  INSTRUMENT_API("getSW_A0");
+  return get<FIELD_SW_A0>();
 }
 
 /**************************************************************************/
@@ -395,6 +863,7 @@ uint8_t PI3EQX12908::getSW_A0(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A0(uint8_t config){
+  INSTRUMENT_API("setConfig_A0");
   _write_reg(CONFIG_A0_REG, config);
 }
 
@@ -407,10 +876,8 @@ void PI3EQX12908::setConfig_A0(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_A0(uint8_t EQ){
-  uint8_t val = getConfig_A0();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_A0_REG, val);
+  INSTRUMENT_API("setEQ_A0");
+  set<FIELD_EQ_A0>(EQ);
 }
 
 /**************************************************************************/
@@ -426,10 +893,8 @@ void PI3EQX12908::setEQ_A0(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_A0(uint8_t flat_gain){
-  uint8_t val = getConfig_A0();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_A0_REG, val);
+  INSTRUMENT_API("setFlatGain_A0");
+  set<FIELD_FG_A0>(flat_gain);
 }
 
 /**************************************************************************/
@@ -443,10 +908,8 @@ void PI3EQX12908::setFlatGain_A0(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_A0(uint8_t swing){
-  uint8_t val = getConfig_A0();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_A0_REG, val);
+  INSTRUMENT_API("setSW_A0");
+  set<FIELD_SW_A0>(swing);
 }
 
 // 4 - A1 Config
@@ -458,6 +921,7 @@ void PI3EQX12908::setSW_A0(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_A1(){
+  INSTRUMENT_API("getConfig_A1");
   return _read_reg(CONFIG_A1_REG);
 }
 
@@ -469,7 +933,8 @@ uint8_t PI3EQX12908::getConfig_A1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_A1(){
-  return _read_reg(CONFIG_A1_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_A1");
+  return get<FIELD_EQ_A1>();
 }
 
 /**************************************************************************/
@@ -484,7 +949,8 @@ uint8_t PI3EQX12908::getEQ_A1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_A1(){
-  return (_read_reg(CONFIG_A1_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_A1");
+  return get<FIELD_FG_A1>();
 }
 
 /**************************************************************************/
@@ -497,7 +963,8 @@ uint8_t PI3EQX12908::getFlatGain_A1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_A1(){
-  return _read_reg(CONFIG_A1_REG) & 0x01;
+  INSTRUMENT_API("getSW_A1");
+  return get<FIELD_SW_A1>();
 }
 
 /**************************************************************************/
@@ -510,6 +977,7 @@ uint8_t PI3EQX12908::getSW_A1(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A1(uint8_t config){
+  INSTRUMENT_API("setConfig_A1");
   _write_reg(CONFIG_A1_REG, config);
 }
 
@@ -522,10 +990,8 @@ void PI3EQX12908::setConfig_A1(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_A1(uint8_t EQ){
-  uint8_t val = getConfig_A1();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_A1_REG, val);
+  INSTRUMENT_API("setEQ_A1");
+  set<FIELD_EQ_A1>(EQ);
 }
 
 /**************************************************************************/
@@ -541,10 +1007,8 @@ void PI3EQX12908::setEQ_A1(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_A1(uint8_t flat_gain){
-  uint8_t val = getConfig_A1();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_A1_REG, val);
+  INSTRUMENT_API("setFlatGain_A1");
+  set<FIELD_FG_A1>(flat_gain);
 }
 
 /**************************************************************************/
@@ -558,10 +1022,8 @@ void PI3EQX12908::setFlatGain_A1(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_A1(uint8_t swing){
-  uint8_t val = getConfig_A1();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_A1_REG, val);
+  INSTRUMENT_API("setSW_A1");
+  set<FIELD_SW_A1>(swing);
 }
 
 // 5 - A2 Config
@@ -573,6 +1035,7 @@ void PI3EQX12908::setSW_A1(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_A2(){
+  INSTRUMENT_API("getConfig_A2");
   return _read_reg(CONFIG_A2_REG);
 }
 
@@ -584,7 +1047,8 @@ uint8_t PI3EQX12908::getConfig_A2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_A2(){
-  return _read_reg(CONFIG_A2_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_A2");
+  return get<FIELD_EQ_A2>();
 }
 
 /**************************************************************************/
@@ -599,7 +1063,8 @@ uint8_t PI3EQX12908::getEQ_A2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_A2(){
-  return (_read_reg(CONFIG_A2_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_A2");
+  return get<FIELD_FG_A2>();
 }
 
 /**************************************************************************/
@@ -612,7 +1077,8 @@ uint8_t PI3EQX12908::getFlatGain_A2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_A2(){
-  return _read_reg(CONFIG_A2_REG) & 0x01;
+  INSTRUMENT_API("getSW_A2");
+  return get<FIELD_SW_A2>();
 }
 
 /**************************************************************************/
@@ -625,6 +1091,7 @@ uint8_t PI3EQX12908::getSW_A2(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A2(uint8_t config){
+  INSTRUMENT_API("setConfig_A2");
   _write_reg(CONFIG_A2_REG, config);
 }
 
@@ -637,10 +1104,8 @@ void PI3EQX12908::setConfig_A2(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_A2(uint8_t EQ){
-  uint8_t val = getConfig_A2();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_A2_REG, val);
+  INSTRUMENT_API("setEQ_A2");
+  set<FIELD_EQ_A2>(EQ);
 }
 
 /**************************************************************************/
@@ -656,10 +1121,8 @@ void PI3EQX12908::setEQ_A2(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_A2(uint8_t flat_gain){
-  uint8_t val = getConfig_A2();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_A2_REG, val);
+  INSTRUMENT_API("setFlatGain_A2");
+  set<FIELD_FG_A2>(flat_gain);
 }
 
 /**************************************************************************/
@@ -673,10 +1136,8 @@ void PI3EQX12908::setFlatGain_A2(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_A2(uint8_t swing){
-  uint8_t val = getConfig_A2();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_A2_REG, val);
+  INSTRUMENT_API("setSW_A2");
+  set<FIELD_SW_A2>(swing);
 }
 
 // 6 - A3 Config
@@ -688,6 +1149,7 @@ void PI3EQX12908::setSW_A2(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_A3(){
+  INSTRUMENT_API("getConfig_A3");
   return _read_reg(CONFIG_A3_REG);
 }
 
@@ -699,7 +1161,8 @@ uint8_t PI3EQX12908::getConfig_A3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_A3(){
-  return _read_reg(CONFIG_A3_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_A3");
+  return get<FIELD_EQ_A3>();
 }
 
 /**************************************************************************/
@@ -714,7 +1177,8 @@ uint8_t PI3EQX12908::getEQ_A3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_A3(){
-  return (_read_reg(CONFIG_A3_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_A3");
+  return get<FIELD_FG_A3>();
 }
 
 /**************************************************************************/
@@ -727,7 +1191,8 @@ uint8_t PI3EQX12908::getFlatGain_A3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_A3(){
-  return _read_reg(CONFIG_A3_REG) & 0x01;
+  INSTRUMENT_API("getSW_A3");
+  return get<FIELD_SW_A3>();
 }
 
 /**************************************************************************/
@@ -740,6 +1205,7 @@ uint8_t PI3EQX12908::getSW_A3(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A3(uint8_t config){
+  INSTRUMENT_API("setConfig_A3");
   _write_reg(CONFIG_A3_REG, config);
 }
 
@@ -752,10 +1218,8 @@ void PI3EQX12908::setConfig_A3(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_A3(uint8_t EQ){
-  uint8_t val = getConfig_A3();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_A3_REG, val);
+  INSTRUMENT_API("setEQ_A3");
+  set<FIELD_EQ_A3>(EQ);
 }
 
 /**************************************************************************/
@@ -771,10 +1235,8 @@ void PI3EQX12908::setEQ_A3(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_A3(uint8_t flat_gain){
-  uint8_t val = getConfig_A3();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_A3_REG, val);
+  INSTRUMENT_API("setFlatGain_A3");
+  set<FIELD_FG_A3>(flat_gain);
 }
 
 /**************************************************************************/
@@ -788,10 +1250,8 @@ void PI3EQX12908::setFlatGain_A3(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_A3(uint8_t swing){
-  uint8_t val = getConfig_A3();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_A3_REG, val);
+  INSTRUMENT_API("setSW_A3");
+  set<FIELD_SW_A3>(swing);
 }
 
 // 7 - B0 Config
@@ -803,6 +1263,7 @@ void PI3EQX12908::setSW_A3(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_B0(){
+  INSTRUMENT_API("getConfig_B0");
   return _read_reg(CONFIG_B0_REG);
 }
 
@@ -814,7 +1275,8 @@ uint8_t PI3EQX12908::getConfig_B0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_B0(){
-  return _read_reg(CONFIG_B0_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_B0");
+  return get<FIELD_EQ_B0>();
 }
 
 /**************************************************************************/
@@ -829,7 +1291,8 @@ uint8_t PI3EQX12908::getEQ_B0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_B0(){
-  return (_read_reg(CONFIG_B0_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_B0");
+  return get<FIELD_FG_B0>();
 }
 
 /**************************************************************************/
@@ -842,7 +1305,8 @@ uint8_t PI3EQX12908::getFlatGain_B0(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_B0(){
-  return _read_reg(CONFIG_B0_REG) & 0x01;
+  INSTRUMENT_API("getSW_B0");
+  return get<FIELD_SW_B0>();
 }
 
 /**************************************************************************/
@@ -855,6 +1319,7 @@ uint8_t PI3EQX12908::getSW_B0(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B0(uint8_t config){
+  INSTRUMENT_API("setConfig_B0");
   _write_reg(CONFIG_B0_REG, config);
 }
 
@@ -867,10 +1332,8 @@ void PI3EQX12908::setConfig_B0(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_B0(uint8_t EQ){
-  uint8_t val = getConfig_B0();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_B0_REG, val);
+  INSTRUMENT_API("setEQ_B0");
+  set<FIELD_EQ_B0>(EQ);
 }
 
 /**************************************************************************/
@@ -886,10 +1349,8 @@ void PI3EQX12908::setEQ_B0(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_B0(uint8_t flat_gain){
-  uint8_t val = getConfig_B0();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_B0_REG, val);
+  INSTRUMENT_API("setFlatGain_B0");
+  set<FIELD_FG_B0>(flat_gain);
 }
 
 /**************************************************************************/
@@ -903,10 +1364,8 @@ void PI3EQX12908::setFlatGain_B0(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_B0(uint8_t swing){
-  uint8_t val = getConfig_B0();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_B0_REG, val);
+  INSTRUMENT_API("setSW_B0");
+  set<FIELD_SW_B0>(swing);
 }
 
 // 8 - B1 Config
@@ -918,6 +1377,7 @@ void PI3EQX12908::setSW_B0(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_B1(){
+  INSTRUMENT_API("getConfig_B1");
   return _read_reg(CONFIG_B1_REG);
 }
 
@@ -929,7 +1389,8 @@ uint8_t PI3EQX12908::getConfig_B1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_B1(){
-  return _read_reg(CONFIG_B1_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_B1");
+  return get<FIELD_EQ_B1>();
 }
 
 /**************************************************************************/
@@ -944,7 +1405,8 @@ uint8_t PI3EQX12908::getEQ_B1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_B1(){
-  return (_read_reg(CONFIG_B1_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_B1");
+  return get<FIELD_FG_B1>();
 }
 
 /**************************************************************************/
@@ -957,7 +1419,8 @@ uint8_t PI3EQX12908::getFlatGain_B1(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_B1(){
-  return _read_reg(CONFIG_B1_REG) & 0x01;
+  INSTRUMENT_API("getSW_B1");
+  return get<FIELD_SW_B1>();
 }
 
 /**************************************************************************/
@@ -970,6 +1433,7 @@ uint8_t PI3EQX12908::getSW_B1(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B1(uint8_t config){
+  INSTRUMENT_API("setConfig_B1");
   _write_reg(CONFIG_B1_REG, config);
 }
 
@@ -982,10 +1446,8 @@ void PI3EQX12908::setConfig_B1(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_B1(uint8_t EQ){
-  uint8_t val = getConfig_B1();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_B1_REG, val);
+  INSTRUMENT_API("setEQ_B1");
+  set<FIELD_EQ_B1>(EQ);
 }
 
 /**************************************************************************/
@@ -1001,10 +1463,8 @@ void PI3EQX12908::setEQ_B1(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_B1(uint8_t flat_gain){
-  uint8_t val = getConfig_B1();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_B1_REG, val);
+  INSTRUMENT_API("setFlatGain_B1");
+  set<FIELD_FG_B1>(flat_gain);
 }
 
 /**************************************************************************/
@@ -1018,10 +1478,8 @@ void PI3EQX12908::setFlatGain_B1(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_B1(uint8_t swing){
-  uint8_t val = getConfig_B1();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_B1_REG, val);
+  INSTRUMENT_API("setSW_B1");
+  set<FIELD_SW_B1>(swing);
 }
 
 // 9 - B2 Config
@@ -1033,6 +1491,7 @@ void PI3EQX12908::setSW_B1(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_B2(){
+  INSTRUMENT_API("getConfig_B2");
   return _read_reg(CONFIG_B2_REG);
 }
 
@@ -1044,7 +1503,8 @@ uint8_t PI3EQX12908::getConfig_B2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_B2(){
-  return _read_reg(CONFIG_B2_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_B2");
+  return get<FIELD_EQ_B2>();
 }
 
 /**************************************************************************/
@@ -1059,7 +1519,8 @@ uint8_t PI3EQX12908::getEQ_B2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_B2(){
-  return (_read_reg(CONFIG_B2_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_B2");
+  return get<FIELD_FG_B2>();
 }
 
 /**************************************************************************/
@@ -1072,7 +1533,8 @@ uint8_t PI3EQX12908::getFlatGain_B2(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_B2(){
-  return _read_reg(CONFIG_B2_REG) & 0x01;
+  INSTRUMENT_API("getSW_B2");
+  return get<FIELD_SW_B2>();
 }
 
 /**************************************************************************/
@@ -1085,6 +1547,7 @@ uint8_t PI3EQX12908::getSW_B2(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B2(uint8_t config){
+  INSTRUMENT_API("setConfig_B2");
   _write_reg(CONFIG_B2_REG, config);
 }
 
@@ -1097,10 +1560,8 @@ void PI3EQX12908::setConfig_B2(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_B2(uint8_t EQ){
-  uint8_t val = getConfig_B2();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_B2_REG, val);
+  INSTRUMENT_API("setEQ_B2");
+  set<FIELD_EQ_B2>(EQ);
 }
 
 /**************************************************************************/
@@ -1116,10 +1577,8 @@ void PI3EQX12908::setEQ_B2(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_B2(uint8_t flat_gain){
-  uint8_t val = getConfig_B2();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_B2_REG, val);
+  INSTRUMENT_API("setFlatGain_B2");
+  set<FIELD_FG_B2>(flat_gain);
 }
 
 /**************************************************************************/
@@ -1133,10 +1592,8 @@ void PI3EQX12908::setFlatGain_B2(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_B2(uint8_t swing){
-  uint8_t val = getConfig_B2();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_B2_REG, val);
+  INSTRUMENT_API("setSW_B2");
+  set<FIELD_SW_B2>(swing);
 }
 
 // 10 - B3 Config
@@ -1148,6 +1605,7 @@ void PI3EQX12908::setSW_B2(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getConfig_B3(){
+  INSTRUMENT_API("getConfig_B3");
   return _read_reg(CONFIG_B3_REG);
 }
 
@@ -1159,7 +1617,8 @@ uint8_t PI3EQX12908::getConfig_B3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getEQ_B3(){
-  return _read_reg(CONFIG_B3_REG) >> EQ_SHIFT;
+  INSTRUMENT_API("getEQ_B3");
+  return get<FIELD_EQ_B3>();
 }
 
 /**************************************************************************/
@@ -1174,7 +1633,8 @@ uint8_t PI3EQX12908::getEQ_B3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getFlatGain_B3(){
-  return (_read_reg(CONFIG_B3_REG) & 0x0F) >> FG_SHIFT;
+  INSTRUMENT_API("getFlatGain_B3");
+  return get<FIELD_FG_B3>();
 }
 
 /**************************************************************************/
@@ -1187,7 +1647,8 @@ uint8_t PI3EQX12908::getFlatGain_B3(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSW_B3(){
-  return _read_reg(CONFIG_B3_REG) & 0x01;
+  INSTRUMENT_API("getSW_B3");
+  return get<FIELD_SW_B3>();
 }
 
 /**************************************************************************/
@@ -1200,6 +1661,7 @@ uint8_t PI3EQX12908::getSW_B3(){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B3(uint8_t config){
+  INSTRUMENT_API("setConfig_B3");
   _write_reg(CONFIG_B3_REG, config);
 }
 
@@ -1212,10 +1674,8 @@ void PI3EQX12908::setConfig_B3(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_B3(uint8_t EQ){
-  uint8_t val = getConfig_B3();
-  val &= 0x0F;
-  val |= (EQ & 0x0F) << EQ_SHIFT;
-  _write_reg(CONFIG_B3_REG, val);
+  INSTRUMENT_API("setEQ_B3");
+  set<FIELD_EQ_B3>(EQ);
 }
 
 /**************************************************************************/
@@ -1231,10 +1691,8 @@ void PI3EQX12908::setEQ_B3(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFlatGain_B3(uint8_t flat_gain){
-  uint8_t val = getConfig_B3();
-  val &= 0xF3;
-  val |= (flat_gain & 0x03) << FG_SHIFT;
-  _write_reg(CONFIG_B3_REG, val);
+  INSTRUMENT_API("setFlatGain_B3");
+  set<FIELD_FG_B3>(flat_gain);
 }
 
 /**************************************************************************/
@@ -1248,10 +1706,8 @@ void PI3EQX12908::setFlatGain_B3(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_B3(uint8_t swing){
-  uint8_t val = getConfig_B3();
-  val &= 0xFE;
-  val |= swing & 0x01;
-  _write_reg(CONFIG_B3_REG, val);
+  INSTRUMENT_API("setSW_B3");
+  set<FIELD_SW_B3>(swing);
 }
 
 // 11 - Signal Detect Config
@@ -1263,6 +1719,7 @@ void PI3EQX12908::setSW_B3(uint8_t swing){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetectConfig(){
+  INSTRUMENT_API("getSignalDetectConfig");
   return _read_reg(SIGNAL_DET_CFG_REG);
 }
 
@@ -1275,7 +1732,8 @@ uint8_t PI3EQX12908::getSignalDetectConfig(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetectConfig_A(){
-  return _read_reg(SIGNAL_DET_CFG_REG) >> 4;
+  INSTRUMENT_API("getSignalDetectConfig_A");
+  return get<FIELD_SIGNAL_DET_CFG_A>();
 }
 
 /**************************************************************************/
@@ -1288,6 +1746,7 @@ uint8_t PI3EQX12908::getSignalDetectConfig_A(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetectConfig_A(uint8_t index){
+  INSTRUMENT_API("getSignalDetectConfig_A(index)");
   return _read_reg(SIGNAL_DET_CFG_REG) & (1 << (index + 4));
 }
 
@@ -1300,7 +1759,8 @@ uint8_t PI3EQX12908::getSignalDetectConfig_A(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetectConfig_B(){
-  return _read_reg(SIGNAL_DET_CFG_REG) & 0x0F;
+  INSTRUMENT_API("getSignalDetectConfig_B");
+  return get<FIELD_SIGNAL_DET_CFG_B>();
 }
 
 /**************************************************************************/
@@ -1313,6 +1773,7 @@ uint8_t PI3EQX12908::getSignalDetectConfig_B(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSignalDetectConfig_B(uint8_t index){
+  INSTRUMENT_API("getSignalDetectConfig_B(index)");
   return _read_reg(SIGNAL_DET_CFG_REG) & (1 << index);
 }
 
@@ -1326,6 +1787,7 @@ uint8_t PI3EQX12908::getSignalDetectConfig_B(uint8_t index){
 */
 /**************************************************************************/
 void PI3EQX12908::setSignalDetectConfig(uint8_t isDown){
+  INSTRUMENT_API("setSignalDetectConfig");
   _write_reg(SIGNAL_DET_CFG_REG, isDown ? 0xFF : 0x00);
 }
 
@@ -1339,12 +1801,8 @@ void PI3EQX12908::setSignalDetectConfig(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setSignalDetectConfig_A(uint8_t isDown){
-  uint8_t val = getSignalDetectConfig();
-  if(isDown)
-    val |= 0xF0;
-  else
-    val &= 0x0F;
-  _write_reg(SIGNAL_DET_CFG_REG, val);
+  INSTRUMENT_API("setSignalDetectConfig_A");
+  set<FIELD_SIGNAL_DET_CFG_A>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -1360,12 +1818,8 @@ void PI3EQX12908::setSignalDetectConfig_A(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setSignalDetectConfig_A(uint8_t index, uint8_t isDown){
-  uint8_t val = getSignalDetectConfig();
-  if(isDown)
-    val |= (1 << (index + 4));
-  else
-    val &= ~(1 << (index + 4));
-  _write_reg(SIGNAL_DET_CFG_REG, val);
+  INSTRUMENT_API("setSignalDetectConfig_A(index)");
+  _update_reg(SIGNAL_DET_CFG_REG, 1 << (index + 4), isDown ? 0xFF : 0x00);
 }
 
 /**************************************************************************/
@@ -1378,12 +1832,8 @@ void PI3EQX12908::setSignalDetectConfig_A(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setSignalDetectConfig_B(uint8_t isDown){
-  uint8_t val = getSignalDetectConfig();
-  if(isDown)
-    val |= 0x0F;
-  else
-    val &= 0xF0;
-  _write_reg(SIGNAL_DET_CFG_REG, val);
+  INSTRUMENT_API("setSignalDetectConfig_B");
+  set<FIELD_SIGNAL_DET_CFG_B>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -1399,12 +1849,8 @@ void PI3EQX12908::setSignalDetectConfig_B(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setSignalDetectConfig_B(uint8_t index, uint8_t isDown){
-  uint8_t val = getSignalDetectConfig();
-  if(isDown)
-    val |= (1 << index);
-  else
-    val &= ~(1 << index);
-  _write_reg(SIGNAL_DET_CFG_REG, val);
+  INSTRUMENT_API("setSignalDetectConfig_B(index)");
+  _update_reg(SIGNAL_DET_CFG_REG, 1 << index, isDown ? 0xFF : 0x00);
 }
 
 // 12 - RX Detect Config
@@ -1416,6 +1862,7 @@ void PI3EQX12908::setSignalDetectConfig_B(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetectConfig(){
+  INSTRUMENT_API("getRxDetectConfig");
   return _read_reg(RX_DET_CFG_REG);
 }
 
@@ -1428,7 +1875,8 @@ uint8_t PI3EQX12908::getRxDetectConfig(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetectConfig_A(){
-  return _read_reg(RX_DET_CFG_REG) >> 4;
+  INSTRUMENT_API("getRxDetectConfig_A");
+  return get<FIELD_RX_DET_CFG_A>();
 }
 
 /**************************************************************************/
@@ -1441,6 +1889,7 @@ uint8_t PI3EQX12908::getRxDetectConfig_A(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetectConfig_A(uint8_t index){
+  INSTRUMENT_API("getRxDetectConfig_A(index)");
   return _read_reg(RX_DET_CFG_REG) & (1 << (index + 4));
 }
 
@@ -1453,7 +1902,8 @@ uint8_t PI3EQX12908::getRxDetectConfig_A(uint8_t index){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetectConfig_B(){
-  return _read_reg(RX_DET_CFG_REG) & 0x0F;
+  INSTRUMENT_API("getRxDetectConfig_B");
+  return get<FIELD_RX_DET_CFG_B>();
 }
 
 /**************************************************************************/
@@ -1466,6 +1916,7 @@ uint8_t PI3EQX12908::getRxDetectConfig_B(){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getRxDetectConfig_B(uint8_t index){
+  INSTRUMENT_API("getRxDetectConfig_B(index)");
   return _read_reg(RX_DET_CFG_REG) & (1 << index);
 }
 
@@ -1479,6 +1930,7 @@ uint8_t PI3EQX12908::getRxDetectConfig_B(uint8_t index){
 */
 /**************************************************************************/
 void PI3EQX12908::setRxDetectConfig(uint8_t isDown){
+  INSTRUMENT_API("setRxDetectConfig");
   _write_reg(RX_DET_CFG_REG, isDown ? 0xFF : 0x00);
 }
 
@@ -1492,12 +1944,8 @@ void PI3EQX12908::setRxDetectConfig(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setRxDetectConfig_A(uint8_t isDown){
-  uint8_t val = getRxDetectConfig();
-  if(isDown)
-    val |= 0xF0;
-  else
-    val &= 0x0F;
-  _write_reg(RX_DET_CFG_REG, val);
+  INSTRUMENT_API("setRxDetectConfig_A");
+  set<FIELD_RX_DET_CFG_A>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -1513,12 +1961,8 @@ void PI3EQX12908::setRxDetectConfig_A(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setRxDetectConfig_A(uint8_t index, uint8_t isDown){
-  uint8_t val = getRxDetectConfig();
-  if(isDown)
-    val |= (1 << (index + 4));
-  else
-    val &= ~(1 << (index + 4));
-  _write_reg(RX_DET_CFG_REG, val);
+  INSTRUMENT_API("setRxDetectConfig_A(index)");
+  _update_reg(RX_DET_CFG_REG, 1 << (index + 4), isDown ? 0xFF : 0x00);
 }
 
 /**************************************************************************/
@@ -1531,12 +1975,8 @@ void PI3EQX12908::setRxDetectConfig_A(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setRxDetectConfig_B(uint8_t isDown){
-  uint8_t val = getRxDetectConfig();
-  if(isDown)
-    val |= 0x0F;
-  else
-    val &= 0xF0;
-  _write_reg(RX_DET_CFG_REG, val);
+  INSTRUMENT_API("setRxDetectConfig_B");
+  set<FIELD_RX_DET_CFG_B>(isDown ? 0x0F : 0x00);
 }
 
 /**************************************************************************/
@@ -1552,12 +1992,8 @@ void PI3EQX12908::setRxDetectConfig_B(uint8_t isDown){
 */
 /**************************************************************************/
 void PI3EQX12908::setRxDetectConfig_B(uint8_t index, uint8_t isDown){
-  uint8_t val = getRxDetectConfig();
-  if(isDown)
-    val |= (1 << index);
-  else
-    val &= ~(1 << index);
-  _write_reg(RX_DET_CFG_REG, val);
+  INSTRUMENT_API("setRxDetectConfig_B(index)");
+  _update_reg(RX_DET_CFG_REG, 1 << index, isDown ? 0xFF : 0x00);
 }
 
 // 13 - Signal Detect Threshold
@@ -1574,7 +2010,8 @@ void PI3EQX12908::setRxDetectConfig_B(uint8_t index, uint8_t isDown){
 */
 /**************************************************************************/
 uint8_t PI3EQX12908::getSDTConfig(){
-  return _read_reg(SIGNAL_DET_TH_REG);
+  INSTRUMENT_API("getSDTConfig");
+  return get<FIELD_SDT>();
 }
 
 /**************************************************************************/
@@ -1590,13 +2027,218 @@ uint8_t PI3EQX12908::getSDTConfig(){
             - #SDT_OFF_110_ON_210_mVpp -> 110 mVpp for off and 210 mVpp for on
 */
 /**************************************************************************/
-uint8_t PI3EQX12908::setSDTConfig(uint8_t thresh){
-  uint8_t val = getSDTConfig();
-  val &= 0x03;
-  val |= (thresh & 0x03) << SDT_SHIFT;
-  _write_reg(SIGNAL_DET_TH_REG, val);
+void PI3EQX12908::setSDTConfig(uint8_t thresh){
+  INSTRUMENT_API("setSDTConfig");
+  set<FIELD_SDT>(thresh);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Estimates the received amplitude of all lanes
+            This function samples the signal detect register at each of
+            the #SDT_LEVELS thresholds and restores the original
+            threshold afterwards. The first sample comes with the read
+            of the threshold register, the other thresholds follow from
+            high to low; each of them costs one
+            write and a 1-byte read, so the whole estimate takes 8
+            transactions. Each sample narrows the bracket of every lane:
+            a detected lane is above the off level of the threshold, or
+            above its on level if it was not detected just before; an
+            undetected lane is below the on level, or below the off
+            level if it was detected just before.
+            A failed access ends the sampling; the bounds then come from
+            the samples taken so far and the original threshold is
+            written back. Do not call it inside a transaction.
+    @param  low_mVpp
+            A pointer to an array of 8 entries, indexed by lane bit
+            (A0..A3 = 4..7, B0..B3 = 0..3), that receives the lower
+            bound of each lane's amplitude (0 if none).
+    @param  high_mVpp
+            A pointer to an array of 8 entries that receives the upper
+            bound (#AMPLITUDE_UNBOUNDED if none).
+    @param  settle_us
+            Delay between a threshold change and its sample, in us.
+    @return #BUS_OK, or the BUS_* status of the first failed access. If
+            the first read fails nothing is written and the bounds are
+            left open.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::estimateAmplitude(uint16_t* low_mVpp, uint16_t* high_mVpp, uint16_t settle_us){
+  INSTRUMENT_API("estimateAmplitude");
+  static const uint8_t off_mVpp[SDT_LEVELS] = {30, 50, 70, 110};
+  static const uint8_t on_mVpp[SDT_LEVELS] = {130, 150, 170, 210};
+  uint8_t data[REG_COUNT];
+  for(uint8_t i=0; i<8; i++){
+    low_mVpp[i] = 0;
+    high_mVpp[i] = AMPLITUDE_UNBOUNDED;
+  }
+  uint8_t status = read(REG_BIT(SIGNAL_DETECT_REG) | REG_BIT(SIGNAL_DET_TH_REG), data);
+  if(status != BUS_OK)
+    return status;
+  uint8_t original = data[SIGNAL_DET_TH_REG];
+  uint8_t first = (original & SDT_MASK) >> SDT_SHIFT;
+  uint8_t detect = data[SIGNAL_DETECT_REG];
+  uint8_t previous = detect;
+  // The current threshold comes with the register read. The others go
+  // from high to low, so a lane that drops out meets falling on levels
+  for(uint8_t n=0; n<SDT_LEVELS; n++){
+    uint8_t level = first;
+    if(n){
+      level = SDT_LEVELS - n;
+      if(level <= first)
+        level--;
+      status = _write_reg(SIGNAL_DET_TH_REG, (original & ~SDT_MASK) | (level << SDT_SHIFT));
+      if(status != BUS_OK)
+        break;
+      if(settle_us)
+        delayMicroseconds(settle_us);
+      status = _bus_read(SIGNAL_DETECT_REG, &detect, 1);
+      if(status != BUS_OK)
+        break;
+    }
+    for(uint8_t i=0; i<8; i++){
+      uint8_t bit = 1 << i;
+      if(detect & bit){
+        uint16_t low = (previous & bit) ? off_mVpp[level] : on_mVpp[level];
+        if(low > low_mVpp[i])
+          low_mVpp[i] = low;
+      }else{
+        uint16_t high = (previous & bit) ? off_mVpp[level] : on_mVpp[level];
+        if(high < high_mVpp[i])
+          high_mVpp[i] = high;
+      }
+    }
+    previous = detect;
+  }
+  uint8_t restore = _write_reg(SIGNAL_DET_TH_REG, original);
+  return status != BUS_OK ? status : restore;
+}
+
+
+// Lane masks
+/**************************************************************************/
+/*!
+    @brief  Gets the signal detect of a set of lanes
+            This function reads the signal detect register once.
+    @param  lanes
+            The lanes to return, e.g. LANE_A1 | LANE_B2 (default all).
+    @return The register masked with lanes.
+*/
+/**************************************************************************/
+LaneMask PI3EQX12908::getSignalDetectMask(LaneMask lanes){
+  INSTRUMENT_API("getSignalDetectMask");
+  return _read_reg(SIGNAL_DETECT_REG) & lanes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the RX detect of a set of lanes
+            This function reads the RX detect register once.
+    @param  lanes
+            The lanes to return, e.g. LANE_A1 | LANE_B2 (default all).
+    @return The register masked with lanes.
+*/
+/**************************************************************************/
+LaneMask PI3EQX12908::getRxDetectMask(LaneMask lanes){
+  INSTRUMENT_API("getRxDetectMask");
+  return _read_reg(RX_DETECT_REG) & lanes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the power down of a set of lanes
+            This function reads the power down register once.
+    @param  lanes
+            The lanes to return, e.g. LANE_A1 | LANE_B2 (default all).
+    @return The register masked with lanes.
+*/
+/**************************************************************************/
+LaneMask PI3EQX12908::getPowerDownMask(LaneMask lanes){
+  INSTRUMENT_API("getPowerDownMask");
+  return _read_reg(POWER_DOWN_REG) & lanes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the signal detect config of a set of lanes
+            This function reads the signal detect config register once.
+    @param  lanes
+            The lanes to return, e.g. LANE_A1 | LANE_B2 (default all).
+    @return The register masked with lanes.
+*/
+/**************************************************************************/
+LaneMask PI3EQX12908::getSignalDetectConfigMask(LaneMask lanes){
+  INSTRUMENT_API("getSignalDetectConfigMask");
+  return _read_reg(SIGNAL_DET_CFG_REG) & lanes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the RX detect config of a set of lanes
+            This function reads the RX detect config register once.
+    @param  lanes
+            The lanes to return, e.g. LANE_A1 | LANE_B2 (default all).
+    @return The register masked with lanes.
+*/
+/**************************************************************************/
+LaneMask PI3EQX12908::getRxDetectConfigMask(LaneMask lanes){
+  INSTRUMENT_API("getRxDetectConfigMask");
+  return _read_reg(RX_DET_CFG_REG) & lanes;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the power down of a set of lanes
+            All lanes in the set are changed with one register update,
+            the other lanes keep their value.
+    @param  lanes
+            The lanes to change, e.g. LANE_A1 | LANE_A3 | LANE_B2.
+    @param  isDown
+            - #CFG_ON  for power up
+            - #CFG_OFF for power down
+*/
+/**************************************************************************/
+void PI3EQX12908::setPowerDownMask(LaneMask lanes, uint8_t isDown){
+  INSTRUMENT_API("setPowerDownMask");
+  if(lanes)
+    _update_reg(POWER_DOWN_REG, lanes, isDown ? 0xFF : 0x00);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the signal detect config of a set of lanes
+            All lanes in the set are changed with one register update,
+            the other lanes keep their value.
+    @param  lanes
+            The lanes to change, e.g. LANE_A1 | LANE_A3 | LANE_B2.
+    @param  isDown
+            - #CFG_ON  for enable
+            - #CFG_OFF for disable
+*/
+/**************************************************************************/
+void PI3EQX12908::setSignalDetectConfigMask(LaneMask lanes, uint8_t isDown){
+  INSTRUMENT_API("setSignalDetectConfigMask");
+  if(lanes)
+    _update_reg(SIGNAL_DET_CFG_REG, lanes, isDown ? 0xFF : 0x00);
 }
 
+/**************************************************************************/
+/*!
+    @brief  Sets the RX detect config of a set of lanes
+            All lanes in the set are changed with one register update,
+            the other lanes keep their value.
+    @param  lanes
+            The lanes to change, e.g. LANE_A1 | LANE_A3 | LANE_B2.
+    @param  isDown
+            - #CFG_ON  for enable
+            - #CFG_OFF for disable
+*/
+/**************************************************************************/
+void PI3EQX12908::setRxDetectConfigMask(LaneMask lanes, uint8_t isDown){
+  INSTRUMENT_API("setRxDetectConfigMask");
+  if(lanes)
+    _update_reg(RX_DET_CFG_REG, lanes, isDown ? 0xFF : 0x00);
+}
 
 // Others
 /**************************************************************************/
@@ -1609,6 +2251,7 @@ uint8_t PI3EQX12908::setSDTConfig(uint8_t thresh){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A(uint8_t config){
+  INSTRUMENT_API("setConfig_A");
   uint8_t data[4] = {config, config, config, config};
   _burst_write(CONFIG_A0_REG, data, 4);
 }
@@ -1624,6 +2267,7 @@ void PI3EQX12908::setConfig_A(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_A(uint8_t index, uint8_t config){
+  INSTRUMENT_API("setConfig_A(index)");
   _write_reg(CONFIG_A_OFFSET + index, config);
 }
 
@@ -1637,6 +2281,7 @@ void PI3EQX12908::setConfig_A(uint8_t index, uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B(uint8_t config){
+  INSTRUMENT_API("setConfig_B");
   uint8_t data[4] = {config, config, config, config};
   _burst_write(CONFIG_B0_REG, data, 4);
 }
@@ -1652,6 +2297,7 @@ void PI3EQX12908::setConfig_B(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig_B(uint8_t index, uint8_t config){
+  INSTRUMENT_API("setConfig_B(index)");
   _write_reg(CONFIG_B_OFFSET + index, config);
 }
 
@@ -1665,6 +2311,7 @@ void PI3EQX12908::setConfig_B(uint8_t index, uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setConfig(uint8_t config){
+  INSTRUMENT_API("setConfig");
   uint8_t data[8] = {config, config, config, config, config, config, config, config};
   _burst_write(CONFIG_A0_REG, data, 8);
 }
@@ -1678,13 +2325,8 @@ void PI3EQX12908::setConfig(uint8_t config){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_A(uint8_t EQ){
-  uint8_t val[4];
-  _burst_read(CONFIG_A0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0x0F;
-    val[i] |= (EQ & 0x0F) << EQ_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 4);
+  INSTRUMENT_API("setEQ_A");
+  _set_channels<FIELD_EQ_A0>(4, EQ);
 }
 
 /**************************************************************************/
@@ -1696,13 +2338,8 @@ void PI3EQX12908::setEQ_A(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ_B(uint8_t EQ){
-  uint8_t val[4];
-  _burst_read(CONFIG_B0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0x0F;
-    val[i] |= (EQ & 0x0F) << EQ_SHIFT;
-  }
-  _burst_write(CONFIG_B0_REG, val, 4);
+  INSTRUMENT_API("setEQ_B");
+  _set_channels<FIELD_EQ_B0>(4, EQ);
 }
 
 /**************************************************************************/
@@ -1714,17 +2351,8 @@ void PI3EQX12908::setEQ_B(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setEQ(uint8_t EQ){
-  //setEQ_A(EQ);
-  //setEQ_B(EQ);
-  //*/
-  uint8_t val[8];
-  _burst_read(CONFIG_A0_REG, val, 8);
-  for(uint8_t i=0; i<8; i++){
-    val[i] &= 0x0F;
-    val[i] |= (EQ & 0x0F) << EQ_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 8);
-  //*/
+  INSTRUMENT_API("setEQ");
+  _set_channels<FIELD_EQ_A0>(8, EQ);
 }
 
 /**************************************************************************/
@@ -1740,13 +2368,8 @@ void PI3EQX12908::setEQ(uint8_t EQ){
 */
 /**************************************************************************/
 void PI3EQX12908::setFG_A(uint8_t flat_gain){
-  uint8_t val[4];
-  _burst_read(CONFIG_A0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0xF3;
-    val[i] |= (flat_gain & 0x03) << FG_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 4);
+  INSTRUMENT_API("setFG_A");
+  _set_channels<FIELD_FG_A0>(4, flat_gain);
 }
 
 /**************************************************************************/
@@ -1762,13 +2385,8 @@ void PI3EQX12908::setFG_A(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setFG_B(uint8_t flat_gain){
-  uint8_t val[4];
-  _burst_read(CONFIG_B0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0xF3;
-    val[i] |= (flat_gain & 0x03) << FG_SHIFT;
-  }
-  _burst_write(CONFIG_B0_REG, val, 4);
+  INSTRUMENT_API("setFG_B");
+  _set_channels<FIELD_FG_B0>(4, flat_gain);
 }
 
 /**************************************************************************/
@@ -1784,17 +2402,8 @@ void PI3EQX12908::setFG_B(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setFG(uint8_t flat_gain){
-  //setFG_A(flat_gain);
-  //setFG_B(flat_gain);
-  //*/
-  uint8_t val[8];
-  _burst_read(CONFIG_A0_REG, val, 8);
-  for(uint8_t i=0; i<8; i++){
-    val[i] &= 0xF3;
-    val[i] |= (flat_gain & 0x03) << FG_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 8);
-  //*/
+  INSTRUMENT_API("setFG");
+  _set_channels<FIELD_FG_A0>(8, flat_gain);
 }
 
 /**************************************************************************/
@@ -1808,13 +2417,8 @@ void PI3EQX12908::setFG(uint8_t flat_gain){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_A(uint8_t swing){
-  uint8_t val[4];
-  _burst_read(CONFIG_A0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0xFE;
-    val[i] |= (swing & 0x01) << SW_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 4);
+  INSTRUMENT_API("setSW_A");
+  _set_channels<FIELD_SW_A0>(4, swing);
 }
 
 /**************************************************************************/
@@ -1828,13 +2432,8 @@ void PI3EQX12908::setSW_A(uint8_t swing){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW_B(uint8_t swing){
-  uint8_t val[4];
-  _burst_read(CONFIG_B0_REG, val, 4);
-  for(uint8_t i=0; i<4; i++){
-    val[i] &= 0xFE;
-    val[i] |= (swing & 0x01) << SW_SHIFT;
-  }
-  _burst_write(CONFIG_B0_REG, val, 4);
+  INSTRUMENT_API("setSW_B");
+  _set_channels<FIELD_SW_B0>(4, swing);
 }
 
 /**************************************************************************/
@@ -1848,17 +2447,8 @@ void PI3EQX12908::setSW_B(uint8_t swing){
 */
 /**************************************************************************/
 void PI3EQX12908::setSW(uint8_t swing){
-  //setSW_A(swing);
-  //setSW_B(swing);
-  //*/
-  uint8_t val[8];
-  _burst_read(CONFIG_A0_REG, val, 8);
-  for(uint8_t i=0; i<8; i++){
-    val[i] &= 0xFE;
-    val[i] |= (swing & 0x01) << SW_SHIFT;
-  }
-  _burst_write(CONFIG_A0_REG, val, 8);
-  //*/
+  INSTRUMENT_API("setSW");
+  _set_channels<FIELD_SW_A0>(8, swing);
 }
 
 /**************************************************************************/
@@ -1869,23 +2459,41 @@ void PI3EQX12908::setSW(uint8_t swing){
 */
 /**************************************************************************/
 void PI3EQX12908::print_all(){
-  uint8_t data[16];
+  print_all(Serial, FORMAT_RAW);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prints all of the registers in a given format
+            This function reads all of the registers with one read and
+            renders them through printRegisters(), which writes the text
+            in #FORMAT_CHUNK byte chunks.
+    @param  out
+            Destination, for example Serial.
+    @param  format
+            #FORMAT_RAW, #FORMAT_DECODED, #FORMAT_CSV or #FORMAT_JSON.
+*/
+/**************************************************************************/
+void PI3EQX12908::print_all(Print& out, uint8_t format){
+  INSTRUMENT_API("print_all");
+  uint8_t data[REG_DUMP_LEN];
   dump_all(data);
-  for(uint8_t i=0; i<16; i++){
-    Serial.print(_REGS[i]);
-    Serial.print(" = BIN: ");
-    Serial.print((data[i] >> 7) & 0x01);
-    Serial.print((data[i] >> 6) & 0x01);
-    Serial.print((data[i] >> 5) & 0x01);
-    Serial.print((data[i] >> 4) & 0x01);
-    Serial.print((data[i] >> 3) & 0x01);
-    Serial.print((data[i] >> 2) & 0x01);
-    Serial.print((data[i] >> 1) & 0x01);
-    Serial.print((data[i] >> 0) & 0x01);
-    Serial.print(" - HEX: 0x");
-    Serial.print(data[i] >> 4, HEX);
-    Serial.println(data[i] & 0x0F, HEX);
-  }
+  printRegisters(out, data, REG_DUMP_LEN, format);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Gets the display name of a register
+            The names are padded to the same width and live in flash;
+            print them with (const __FlashStringHelper*) or copy them
+            with strcpy_P().
+    @param  mem_addr
+            Register address, 0 to #REG_DUMP_LEN - 1.
+    @return A PROGMEM pointer to the zero terminated name.
+*/
+/**************************************************************************/
+const char* PI3EQX12908::regName(uint8_t mem_addr){
+  return _REG_NAMES[mem_addr < REG_DUMP_LEN ? mem_addr : REG_DUMP_LEN - 1];
 }
 
 /**************************************************************************/
@@ -1898,41 +2506,483 @@ void PI3EQX12908::print_all(){
 */
 /**************************************************************************/
 void PI3EQX12908::dump_all(uint8_t* data){
+  INSTRUMENT_API("dump_all");
   _burst_read(0, data, 16);
 }
 
+/**************************************************************************/
+/*!
+    @brief  Takes a decoded snapshot of the chip
+            This function reads registers 0 to 13 in a single transaction
+            and decodes them into the given state.
+    @param  state
+            A reference to the state to fill.
+*/
+/**************************************************************************/
+void PI3EQX12908::snapshot(RedriverState& state){
+  INSTRUMENT_API("snapshot");
+  uint8_t data[REG_COUNT];
+  _burst_read(0, data, REG_COUNT);
+  state.decode(data);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads the writable register image
+            This function reads registers #POWER_DOWN_REG to
+            #SIGNAL_DET_TH_REG (from the shadow cache when it is valid).
+    @param  image
+            A pointer to an array of #SHADOW_LEN bytes.
+*/
+/**************************************************************************/
+void PI3EQX12908::readImage(uint8_t* image){
+  INSTRUMENT_API("readImage");
+  _burst_read(SHADOW_FIRST_REG, image, SHADOW_LEN);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes the writable register image
+            This function writes registers #POWER_DOWN_REG to
+            #SIGNAL_DET_TH_REG with a single burst write.
+    @param  image
+            A pointer to an array of #SHADOW_LEN bytes.
+    @return #BUS_OK or the BUS_* status of the failed write.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::writeImage(const uint8_t* image){
+  INSTRUMENT_API("writeImage");
+  return _burst_write(SHADOW_FIRST_REG, (uint8_t*)image, SHADOW_LEN);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a writable register image stored in flash
+            Same as writeImage(), for an image in PROGMEM, for example
+            one built with RedriverConfig and #REDRIVER_CONFIG_IMAGE.
+    @param  image
+            A pointer to an array of #SHADOW_LEN bytes in PROGMEM.
+    @return #BUS_OK or the BUS_* status of the failed write.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::writeImage_P(const uint8_t* image){
+  INSTRUMENT_API("writeImage_P");
+  uint8_t data[SHADOW_LEN];
+  memcpy_P(data, image, SHADOW_LEN);
+  return _burst_write(SHADOW_FIRST_REG, data, SHADOW_LEN);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Applies a configuration profile
+            This function writes the profile image with a single burst
+            write, see writeImage().
+    @param  profile
+            A profile loaded from a ProfileStore or built in code.
+*/
+/**************************************************************************/
+void PI3EQX12908::applyProfile(const RedriverProfile& profile){
+  INSTRUMENT_API("applyProfile");
+  writeImage(profile.image);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Captures the current configuration into a profile
+            Only the image is changed; set the name and revision of the
+            profile separately.
+    @param  profile
+            Receives the register image.
+*/
+/**************************************************************************/
+void PI3EQX12908::captureProfile(RedriverProfile& profile){
+  INSTRUMENT_API("captureProfile");
+  readImage(profile.image);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Brings the chip to a desired state, writing only what differs
+            The desired image is compared with the shadow cache (or, if
+            the cache is off, with one read of the chip) and only the
+            changed registers are written, see commit() for how they are
+            grouped into bursts. With the cache on, applying an unchanged
+            state costs no bus access. Inside a transaction the changes
+            are collected for commit().
+    @param  desired
+            The state to apply, as encoded by RedriverState::encode().
+            Registers with nothing to write are ignored.
+    @param  count
+            If not NULL, receives the number of I2C write transactions
+            issued, 0 when nothing had to change or on a failed read.
+    @return #BUS_OK, or the BUS_* status of the failed read (nothing is
+            written then) or of the last failed write.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908::apply(const RedriverState& desired, uint8_t* count){
+  INSTRUMENT_API("apply");
+  uint8_t image[REG_COUNT];
+  uint8_t current[SHADOW_LEN];
+  uint8_t writes = 0;
+  if(count)
+    *count = 0;
+  desired.encode(image);
+  uint8_t status = _burst_read(SHADOW_FIRST_REG, current, SHADOW_LEN);
+  if(status != BUS_OK)
+    return status;
+  uint16_t dirty = 0;
+  for(uint8_t reg=SHADOW_FIRST_REG; reg<=SHADOW_LAST_REG; reg++)
+    if(image[reg] != current[reg - SHADOW_FIRST_REG])
+      dirty |= REG_BIT(reg);
+  if(_in_txn){
+    for(uint8_t reg=SHADOW_FIRST_REG; reg<=SHADOW_LAST_REG; reg++)
+      _shadow[reg - SHADOW_FIRST_REG] = image[reg];
+    _dirty |= dirty;
+    return BUS_OK;
+  }
+  status = _write_runs(dirty, &image[SHADOW_FIRST_REG], writes);
+  if(count)
+    *count = writes;
+  return status;
+}
+
+// Redriver state
+/**************************************************************************/
+/*!
+    @brief  Decodes a raw register image
+            This function copies the image and splits every register
+            into its fields.
+    @param  data
+            A pointer to #REG_COUNT bytes starting at register 0.
+*/
+/**************************************************************************/
+void RedriverState::decode(const uint8_t* data){
+  for(uint8_t i=0; i<REG_COUNT; i++)
+    regs[i] = data[i];
+  signal_detect = regs[SIGNAL_DETECT_REG];
+  rx_detect     = regs[RX_DETECT_REG];
+  power_down    = regs[POWER_DOWN_REG];
+  for(uint8_t i=0; i<8; i++){
+    uint8_t config = regs[CONFIG_A0_REG + i];
+    eq[i]        = config >> EQ_SHIFT;
+    flat_gain[i] = (config >> FG_SHIFT) & 0x03;
+    swing[i]     = (config >> SW_SHIFT) & 0x01;
+  }
+  sd_config = regs[SIGNAL_DET_CFG_REG];
+  rx_config = regs[RX_DET_CFG_REG];
+  sdt       = (regs[SIGNAL_DET_TH_REG] >> SDT_SHIFT) & 0x03;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Encodes the decoded fields into a raw register image
+            Bits that have no decoded field are taken from the raw
+            image, so decode() followed by encode() is lossless.
+    @param  data
+            A pointer to #REG_COUNT bytes starting at register 0.
+*/
+/**************************************************************************/
+void RedriverState::encode(uint8_t* data) const{
+  for(uint8_t i=0; i<REG_COUNT; i++)
+    data[i] = regs[i];
+  data[SIGNAL_DETECT_REG] = signal_detect;
+  data[RX_DETECT_REG]     = rx_detect;
+  data[POWER_DOWN_REG]    = power_down;
+  for(uint8_t i=0; i<8; i++){
+    uint8_t config = data[CONFIG_A0_REG + i] & 0x02;
+    config |= (eq[i] & 0x0F) << EQ_SHIFT;
+    config |= (flat_gain[i] & 0x03) << FG_SHIFT;
+    config |= (swing[i] & 0x01) << SW_SHIFT;
+    data[CONFIG_A0_REG + i] = config;
+  }
+  data[SIGNAL_DET_CFG_REG] = sd_config;
+  data[RX_DET_CFG_REG]     = rx_config;
+  data[SIGNAL_DET_TH_REG]  = (data[SIGNAL_DET_TH_REG] & ~(0x03 << SDT_SHIFT)) | ((sdt & 0x03) << SDT_SHIFT);
+}
+
 uint8_t PI3EQX12908::_read_reg(uint8_t mem_addr){
-  //Wire.beginTransmission(_I2C_ADDR);
-  //Wire.write(mem_addr);
-  //Wire.endTransmission();
-  Wire.requestFrom(_I2C_ADDR, (uint8_t)(mem_addr + 1));
-  for(uint8_t i=0; i<mem_addr; i++)
-    Wire.read();
-  return Wire.read();
-}
-
-void PI3EQX12908::_write_reg(uint8_t mem_addr, uint8_t value){
-  Wire.beginTransmission(_I2C_ADDR);
-  Wire.write(mem_addr);
-  Wire.write(value);
-  Wire.endTransmission();
-}
-
-void PI3EQX12908::_burst_read(uint8_t mem_addr, uint8_t* data, uint8_t len){
-  //Wire.beginTransmission(_I2C_ADDR);
-  //Wire.write(mem_addr);
-  //Wire.endTransmission();
-  Wire.requestFrom(_I2C_ADDR, (uint8_t)(mem_addr + len));
-  for(uint8_t i=0; i<mem_addr; i++)
-    Wire.read();
+  uint8_t value;
+  _burst_read(mem_addr, &value, 1);
+  return value;
+}
+
+uint8_t PI3EQX12908::_write_reg(uint8_t mem_addr, uint8_t value){
+  return _burst_write(mem_addr, &value, 1);
+}
+
+uint8_t PI3EQX12908::_burst_read(uint8_t mem_addr, uint8_t* data, uint8_t len){
+  INSTRUMENT_BURST(TRACE_READ);
+  uint16_t mask = (uint16_t)((REG_BIT(len) - 1) << mem_addr);
+  if(_rx_pending && (_rx_pending & mask) == mask){
+    for(uint8_t i=0; i<len; i++)
+      data[i] = _rx[mem_addr + i];
+    _rx_pending &= ~mask;
+    INSTRUMENT_CACHE_HIT();
+    return BUS_OK;
+  }
+  if(_shadow_ready(mem_addr, len)){
+    for(uint8_t i=0; i<len; i++)
+      data[i] = _shadow[mem_addr - SHADOW_FIRST_REG + i];
+    INSTRUMENT_CACHE_HIT();
+    return BUS_OK;
+  }
+  uint8_t status = _bus_read(mem_addr, data, len);
+  // A read that covers the whole writable range refreshes the shadow for free
+  if(status == BUS_OK && _cache_enabled && mem_addr <= SHADOW_FIRST_REG && mem_addr + len > SHADOW_LAST_REG)
+    _load_shadow(&data[SHADOW_FIRST_REG - mem_addr]);
+  return status;
+}
+
+uint8_t PI3EQX12908::_burst_write(uint8_t mem_addr, uint8_t* data, uint8_t len){
+  INSTRUMENT_BURST(TRACE_WRITE);
+  uint16_t mask = (uint16_t)((REG_BIT(len) - 1) << mem_addr);
+  if(_in_txn && mem_addr >= SHADOW_FIRST_REG && mem_addr + len - 1 <= SHADOW_LAST_REG){
+    for(uint8_t i=0; i<len; i++){
+      _shadow[mem_addr - SHADOW_FIRST_REG + i] = data[i];
+      _dirty |= 1 << (mem_addr + i);
+    }
+    _patch_rx(mem_addr, data, len);
+    INSTRUMENT_BUFFERED();
+    return BUS_OK;
+  }
+  uint8_t status = _bus_write(mem_addr, data, len);
+  if(status != BUS_OK){
+    // Part of the burst may have landed, the shadow and the prefetched
+    // bytes no longer match the chip
+    _shadow_valid = false;
+    _rx_pending &= ~mask;
+    return status;
+  }
+  _patch_rx(mem_addr, data, len);
+  if((_cache_enabled || _in_txn) && _shadow_valid){
+    for(uint8_t i=0; i<len; i++){
+      uint8_t reg = mem_addr + i;
+      if(reg >= SHADOW_FIRST_REG && reg <= SHADOW_LAST_REG)
+        _shadow[reg - SHADOW_FIRST_REG] = data[i];
+    }
+  }
+  return BUS_OK;
+}
+
+uint8_t PI3EQX12908::_update_reg(uint8_t mem_addr, uint8_t mask, uint8_t value){
+  uint8_t val = value & mask;
+  if(mask != 0xFF){
+    uint8_t old;
+    uint8_t status = _burst_read(mem_addr, &old, 1);
+    // Never write back bits from a failed read
+    if(status != BUS_OK)
+      return status;
+    val |= old & ~mask;
+  }
+  return _write_reg(mem_addr, val);
+}
+
+// Writes the dirty registers of an image that starts at SHADOW_FIRST_REG.
+// A clean gap costs one byte per register when rewritten, a separate
+// burst costs the address and register bytes plus START/STOP, so gaps of
+// up to max_gap registers are written through; the image must hold the
+// current value of every clean register unless max_gap is 0.
+uint8_t PI3EQX12908::_write_runs(uint16_t dirty, uint8_t* image, uint8_t& count, uint8_t max_gap){
+  uint8_t status = BUS_OK;
+  count = 0;
+  uint8_t reg = SHADOW_FIRST_REG;
+  while(reg <= SHADOW_LAST_REG){
+    if(!(dirty & REG_BIT(reg))){
+      reg++;
+      continue;
+    }
+    uint8_t last = reg;
+    for(uint8_t next=reg+1; next<=SHADOW_LAST_REG && next - last - 1 <= max_gap; next++)
+      if(dirty & REG_BIT(next))
+        last = next;
+    uint8_t result = _burst_write(reg, &image[reg - SHADOW_FIRST_REG], last - reg + 1);
+    if(result != BUS_OK)
+      status = result;
+    count++;
+    reg = last + 1;
+  }
+  return status;
+}
+
+// Keeps prefetched bytes not yet consumed in step with a write
+void PI3EQX12908::_patch_rx(uint8_t mem_addr, const uint8_t* data, uint8_t len){
   for(uint8_t i=0; i<len; i++)
-    data[i] = Wire.read();
+    if(_rx_pending & REG_BIT(mem_addr + i))
+      _rx[mem_addr + i] = data[i];
+}
+
+// Fills the shadow from a chip image of the writable registers. Registers
+// still dirty in an open transaction hold a pending write and are kept.
+void PI3EQX12908::_load_shadow(const uint8_t* image){
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    if(!(_in_txn && (_dirty & REG_BIT(SHADOW_FIRST_REG + i))))
+      _shadow[i] = image[i];
+  _shadow_valid = true;
+}
+
+bool PI3EQX12908::_shadow_ready(uint8_t mem_addr, uint8_t len){
+  if(!(_cache_enabled || _in_txn) || mem_addr < SHADOW_FIRST_REG || mem_addr + len - 1 > SHADOW_LAST_REG)
+    return false;
+  if(!_shadow_valid)
+    resync();
+  return _shadow_valid;
+}
+
+uint8_t PI3EQX12908::_bus_read(uint8_t mem_addr, uint8_t* data, uint8_t len){
+  // The chip always answers from register 0, so read the prefix as well
+  uint8_t buf[REG_DUMP_LEN];
+  unsigned long start = micros();
+  uint8_t status = _bus->read(_I2C_ADDR, buf, mem_addr + len);
+  for(uint8_t attempt=0; status != BUS_OK && attempt < _retries; attempt++){
+    _retry_wait(status, attempt);
+    status = _bus->read(_I2C_ADDR, buf, mem_addr + len);
+  }
+  for(uint8_t i=0; i<len; i++)
+    data[i] = status == BUS_OK ? buf[mem_addr + i] : 0;
+  INSTRUMENT_BUS(_I2C_ADDR, TRACE_READ, mem_addr, len, status, start);
+  return _account(status, start);
 }
 
-void PI3EQX12908::_burst_write(uint8_t mem_addr, uint8_t* data, uint8_t len){
-  Wire.beginTransmission(_I2C_ADDR);
-  Wire.write(mem_addr);
+uint8_t PI3EQX12908::_bus_write(uint8_t mem_addr, uint8_t* data, uint8_t len){
+  uint8_t buf[REG_DUMP_LEN + 1];
+  buf[0] = mem_addr;
   for(uint8_t i=0; i<len; i++)
-    Wire.write(data[i]);
-  Wire.endTransmission();
+    buf[i + 1] = data[i];
+  unsigned long start = micros();
+  uint8_t status = _bus->write(_I2C_ADDR, buf, len + 1);
+  for(uint8_t attempt=0; status != BUS_OK && attempt < _retries; attempt++){
+    _retry_wait(status, attempt);
+    status = _bus->write(_I2C_ADDR, buf, len + 1);
+  }
+  INSTRUMENT_BUS(_I2C_ADDR, TRACE_WRITE, mem_addr, len, status, start);
+  return _account(status, start);
+}
+
+void PI3EQX12908::_retry_wait(uint8_t status, uint8_t attempt){
+  // A timeout or arbitration/bus error hints at a device holding the bus
+  if(status == BUS_ERR_TIMEOUT || status == BUS_ERR_OTHER)
+    _bus->recover();
+  uint32_t wait = (uint32_t)_backoff_us << attempt;
+  while(wait > 16000){
+    delayMicroseconds(16000);
+    wait -= 16000;
+  }
+  if(wait)
+    delayMicroseconds(wait);
+}
+
+uint8_t PI3EQX12908::_account(uint8_t status, unsigned long start){
+  uint32_t elapsed = micros() - start;
+  if(elapsed > _worst_us)
+    _worst_us = elapsed;
+  _last_error = status;
+  if(status != BUS_OK && _errors < 0xFFFF)
+    _errors++;
+  return status;
+}
+
+#ifdef PI3EQX12908_WIRE_BUS
+// Wire transport
+/**************************************************************************/
+/*!
+    @brief  Writes a buffer to a device in one transaction
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the bytes to send.
+    @param  len
+            Number of bytes to send.
+    @return #BUS_OK or the error code of endTransmission().
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908_WireBus::write(uint8_t i2c_addr, const uint8_t* data, uint8_t len){
+  _wire->beginTransmission(i2c_addr);
+  _wire->write(data, len);
+  return _wire->endTransmission();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a buffer from a device in one transaction
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the array to store the bytes.
+    @param  len
+            Number of bytes to read.
+    @return #BUS_OK, #BUS_ERR_TIMEOUT if the Wire timeout hit, or
+            #BUS_ERR_SHORT_READ if fewer bytes arrived.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908_WireBus::read(uint8_t i2c_addr, uint8_t* data, uint8_t len){
+  uint8_t count = _wire->requestFrom(i2c_addr, len);
+  for(uint8_t i=0; i<count && i<len; i++)
+    data[i] = _wire->read();
+  if(count >= len)
+    return BUS_OK;
+#ifdef WIRE_HAS_TIMEOUT
+  if(_wire->getWireTimeoutFlag()){
+    _wire->clearWireTimeoutFlag();
+    return BUS_ERR_TIMEOUT;
+  }
+#endif
+  return BUS_ERR_SHORT_READ;
 }
+
+/**************************************************************************/
+/*!
+    @brief  Bounds the duration of a transaction
+            Uses the Wire timeout of cores that have one
+            (WIRE_HAS_TIMEOUT); a timed out transaction returns
+            #BUS_ERR_TIMEOUT and resets the TWI hardware. On other cores
+            this does nothing.
+    @param  us
+            Timeout in us.
+*/
+/**************************************************************************/
+void PI3EQX12908_WireBus::setTimeout(uint32_t us){
+#ifdef WIRE_HAS_TIMEOUT
+  _wire->setWireTimeout(us, true);
+#else
+  (void)us;
+#endif
+}
+
+/**************************************************************************/
+/*!
+    @brief  Frees a bus held low by a device
+            Releases Wire, clocks SCL up to 9 times until the device lets
+            go of SDA, sends a STOP and starts Wire again at the clock
+            given to setClock() (begin() resets it to the core default).
+            Needs the pins set with setRecoveryPins().
+    @return true if SDA is high afterwards.
+*/
+/**************************************************************************/
+bool PI3EQX12908_WireBus::recover(){
+  if(_scl == 0xFF || _sda == 0xFF)
+    return false;
+  _wire->end();
+  // Open drain: drive low with OUTPUT/LOW, release with INPUT_PULLUP
+  pinMode(_sda, INPUT_PULLUP);
+  pinMode(_scl, INPUT_PULLUP);
+  delayMicroseconds(5);
+  for(uint8_t i=0; i<9 && digitalRead(_sda) == LOW; i++){
+    pinMode(_scl, OUTPUT);
+    digitalWrite(_scl, LOW);
+    delayMicroseconds(5);
+    pinMode(_scl, INPUT_PULLUP);
+    delayMicroseconds(5);
+  }
+  // STOP: SDA rises while SCL is high
+  pinMode(_sda, OUTPUT);
+  digitalWrite(_sda, LOW);
+  delayMicroseconds(5);
+  pinMode(_sda, INPUT_PULLUP);
+  delayMicroseconds(5);
+  bool released = digitalRead(_sda) == HIGH;
+  _wire->begin();
+  if(_clock)
+    _wire->setClock(_clock);
+  return released;
+}
+#endif
@@ -15,8 +15,7 @@
 #define _PI3EQX12908_H
 
 #include <stdint.h>
-#include <Wire.h>
-#include <String.h>
+#include <stddef.h>
 
 #define SIGNAL_DETECT_REG   0
 #define RX_DETECT_REG       1
@@ -51,6 +50,53 @@
 
 #define SDT_SHIFT 1
 
+#define EQ_MASK   0xF0
+#define FG_MASK   0x0C
+#define SW_MASK   0x01
+#define SDT_MASK  0x06
+
+#define BANK_A    0 ///< Channel bank A (A0 to A3)
+#define BANK_B    1 ///< Channel bank B (B0 to B3)
+
+typedef uint8_t LaneMask; ///< Set of lanes in the bit-per-lane registers, built from the LANE_* bits
+
+#define LANE_A0     0x10 ///< Lane A0 in a #LaneMask
+#define LANE_A1     0x20 ///< Lane A1 in a #LaneMask
+#define LANE_A2     0x40 ///< Lane A2 in a #LaneMask
+#define LANE_A3     0x80 ///< Lane A3 in a #LaneMask
+#define LANE_B0     0x01 ///< Lane B0 in a #LaneMask
+#define LANE_B1     0x02 ///< Lane B1 in a #LaneMask
+#define LANE_B2     0x04 ///< Lane B2 in a #LaneMask
+#define LANE_B3     0x08 ///< Lane B3 in a #LaneMask
+#define LANE_A(i)   ((LaneMask)(0x10 << (i))) ///< Lane A0 to A3 by index
+#define LANE_B(i)   ((LaneMask)(0x01 << (i))) ///< Lane B0 to B3 by index
+#define LANES_A     0xF0 ///< All lanes of bank A
+#define LANES_B     0x0F ///< All lanes of bank B
+#define LANES_ALL   0xFF ///< All lanes
+
+#define SHADOW_FIRST_REG  POWER_DOWN_REG                          ///< First register kept in the shadow cache
+#define SHADOW_LAST_REG   SIGNAL_DET_TH_REG                       ///< Last register kept in the shadow cache
+#define SHADOW_LEN        (SHADOW_LAST_REG - SHADOW_FIRST_REG + 1) ///< Number of registers in the shadow cache
+
+#define REG_COUNT         (SIGNAL_DET_TH_REG + 1)                 ///< Number of registers in the register map
+#define REG_BIT(reg)      ((uint16_t)1 << (reg))                  ///< Register bit for prefetch()/read() masks
+#define REG_DUMP_LEN      16                                      ///< Number of bytes returned by dump_all()
+
+#ifndef WRITE_MERGE_GAP
+#define WRITE_MERGE_GAP   2 ///< Unchanged registers rewritten to join two runs of changed ones into one write, at most the address and register bytes a second write would cost
+#endif
+
+#define BUS_OK              0 ///< Transfer completed
+#define BUS_ERR_TOO_LONG    1 ///< Data too long for the transmit buffer
+#define BUS_ERR_NACK_ADDR   2 ///< Address not acknowledged
+#define BUS_ERR_NACK_DATA   3 ///< Data not acknowledged
+#define BUS_ERR_OTHER       4 ///< Other bus error
+#define BUS_ERR_TIMEOUT     5 ///< Bus timeout
+#define BUS_ERR_SHORT_READ  6 ///< Fewer bytes received than requested
+
+#define DEFAULT_RETRIES     2   ///< Retries of a failed bus access
+#define DEFAULT_BACKOFF_US  100 ///< Delay before the first retry, doubled for every further one
+
 #define FLAT_GAIN_M4db 0  ///< Flat gain = -4db
 #define FLAT_GAIN_M2db 1  ///< Flat gain = -2db
 #define FLAT_GAIN_00db 2  ///< Flat gain =  0db
@@ -63,10 +109,461 @@
 #define SDT_OFF_50_ON_150_mVpp   1  ///< Signal detect threshold =  50 mVpp for off and 150 mVpp for on
 #define SDT_OFF_70_ON_170_mVpp   2  ///< Signal detect threshold =  70 mVpp for off and 170 mVpp for on
 #define SDT_OFF_110_ON_210_mVpp  3  ///< Signal detect threshold = 110 mVpp for off and 210 mVpp for on
+#define SDT_LEVELS               4  ///< Number of signal detect thresholds
+#define AMPLITUDE_UNBOUNDED      0xFFFF  ///< Upper amplitude bound of a lane detected at every threshold
 
 #define CFG_ON  0 ///< Use this for power down state
 #define CFG_OFF 1 ///< Use this for power up state
 
+/*
+ * Bus transport
+ *
+ * The driver talks to the chip through a transport class selected at
+ * compile time, so every access is a direct (inlinable) call. A transport
+ * provides:
+ *   uint8_t write(uint8_t i2c_addr, const uint8_t* data, uint8_t len);
+ *   uint8_t read(uint8_t i2c_addr, uint8_t* data, uint8_t len);
+ *   bool recover();
+ * write and read return one of the BUS_* status codes and must give up
+ * after a bounded time. recover() frees a stuck bus and returns false if
+ * the transport cannot do that. The default transport
+ * wraps a TwoWire instance (Wire, Wire1, ...). To use another one, define
+ * PI3EQX12908_BUS_HEADER as the quoted header that declares it for the
+ * whole build; that header (or the build) defines PI3EQX12908_BUS as the
+ * class name. extras/host has a Linux i2c-dev transport.
+ */
+#ifdef PI3EQX12908_BUS_HEADER
+#include PI3EQX12908_BUS_HEADER
+#endif
+
+#ifndef PI3EQX12908_BUS
+#include <Wire.h>
+
+/**************************************************************************/
+/*! 
+    @brief  Transport over an Arduino TwoWire instance
+*/
+/**************************************************************************/
+class PI3EQX12908_WireBus{
+  public:
+    PI3EQX12908_WireBus(TwoWire& wire = Wire) : _wire(&wire), _clock(0), _scl(0xFF), _sda(0xFF) {}
+    void setRecoveryPins(uint8_t scl, uint8_t sda) { _scl = scl; _sda = sda; } ///< Pins used by recover()
+    void setClock(uint32_t hz) { _clock = hz; _wire->setClock(hz); }          ///< Sets the SCL frequency and restores it after recover()
+    void setTimeout(uint32_t us);
+    uint8_t write(uint8_t i2c_addr, const uint8_t* data, uint8_t len);
+    uint8_t read(uint8_t i2c_addr, uint8_t* data, uint8_t len);
+    bool recover();
+
+  private:
+    TwoWire* _wire;
+    uint32_t _clock;
+    uint8_t  _scl;
+    uint8_t  _sda;
+};
+
+#define PI3EQX12908_BUS PI3EQX12908_WireBus
+#define PI3EQX12908_WIRE_BUS
+#endif
+
+/**************************************************************************/
+/*! 
+    @brief  Decoded point-in-time copy of all registers of the redriver
+            Filled by PI3EQX12908::snapshot() with a single read. Channel
+            arrays are indexed 0 to 3 for A0 to A3 and 4 to 7 for B0 to B3.
+            The accessors mirror the PI3EQX12908 getters without bus access.
+*/
+/**************************************************************************/
+struct RedriverState{
+  uint8_t regs[REG_COUNT];  ///< Raw register image as read from the chip
+  uint8_t signal_detect;    ///< Signal detect bitmap (read only)
+  uint8_t rx_detect;        ///< RX detect bitmap (read only)
+  uint8_t power_down;       ///< Power down bitmap
+  uint8_t eq[8];            ///< Equalizer index per channel
+  uint8_t flat_gain[8];     ///< Flat gain per channel
+  uint8_t swing[8];         ///< Swing per channel
+  uint8_t sd_config;        ///< Signal detect config bitmap
+  uint8_t rx_config;        ///< RX detect config bitmap
+  uint8_t sdt;              ///< Signal detect threshold
+
+  void decode(const uint8_t* data);
+  void encode(uint8_t* data) const;
+
+  uint8_t getSignalDetect() const                      { return signal_detect; }                         ///< Same as PI3EQX12908::getSignalDetect()
+  uint8_t getSignalDetect_A() const                    { return signal_detect >> 4; }                    ///< Same as PI3EQX12908::getSignalDetect_A()
+  uint8_t getSignalDetect_A(uint8_t index) const       { return signal_detect & (1 << (index + 4)); }    ///< Same as PI3EQX12908::getSignalDetect_A(uint8_t)
+  uint8_t getSignalDetect_B() const                    { return signal_detect & 0x0F; }                  ///< Same as PI3EQX12908::getSignalDetect_B()
+  uint8_t getSignalDetect_B(uint8_t index) const       { return signal_detect & (1 << index); }          ///< Same as PI3EQX12908::getSignalDetect_B(uint8_t)
+  uint8_t getRxDetect() const                          { return rx_detect; }                             ///< Same as PI3EQX12908::getRxDetect()
+  uint8_t getRxDetect_A() const                        { return rx_detect >> 4; }                        ///< Same as PI3EQX12908::getRxDetect_A()
+  uint8_t getRxDetect_A(uint8_t index) const           { return rx_detect & (1 << (index + 4)); }        ///< Same as PI3EQX12908::getRxDetect_A(uint8_t)
+  uint8_t getRxDetect_B() const                        { return rx_detect & 0x0F; }                      ///< Same as PI3EQX12908::getRxDetect_B()
+  uint8_t getRxDetect_B(uint8_t index) const           { return rx_detect & (1 << index); }              ///< Same as PI3EQX12908::getRxDetect_B(uint8_t)
+  uint8_t getPowerDown() const                         { return power_down; }                            ///< Same as PI3EQX12908::getPowerDown()
+  uint8_t getPowerDown_A() const                       { return power_down >> 4; }                       ///< Same as PI3EQX12908::getPowerDown_A()
+  uint8_t getPowerDown_A(uint8_t index) const          { return power_down & (1 << (index + 4)); }       ///< Same as PI3EQX12908::getPowerDown_A(uint8_t)
+  uint8_t getPowerDown_B() const                       { return power_down & 0x0F; }                     ///< Same as PI3EQX12908::getPowerDown_B()
+  uint8_t getPowerDown_B(uint8_t index) const          { return power_down & (1 << index); }             ///< Same as PI3EQX12908::getPowerDown_B(uint8_t)
+  uint8_t getConfig_A(uint8_t index) const             { return regs[CONFIG_A_OFFSET + index]; }         ///< Same as PI3EQX12908::getConfig_Ax()
+  uint8_t getConfig_B(uint8_t index) const             { return regs[CONFIG_B_OFFSET + index]; }         ///< Same as PI3EQX12908::getConfig_Bx()
+  uint8_t getEQ_A(uint8_t index) const                 { return eq[index]; }                             ///< Same as PI3EQX12908::getEQ_Ax()
+  uint8_t getEQ_B(uint8_t index) const                 { return eq[4 + index]; }                         ///< Same as PI3EQX12908::getEQ_Bx()
+  uint8_t getFlatGain_A(uint8_t index) const           { return flat_gain[index]; }                      ///< Same as PI3EQX12908::getFlatGain_Ax()
+  uint8_t getFlatGain_B(uint8_t index) const           { return flat_gain[4 + index]; }                  ///< Same as PI3EQX12908::getFlatGain_Bx()
+  uint8_t getSW_A(uint8_t index) const                 { return swing[index]; }                          ///< Same as PI3EQX12908::getSW_Ax()
+  uint8_t getSW_B(uint8_t index) const                 { return swing[4 + index]; }                      ///< Same as PI3EQX12908::getSW_Bx()
+  uint8_t getSignalDetectConfig() const                { return sd_config; }                             ///< Same as PI3EQX12908::getSignalDetectConfig()
+  uint8_t getSignalDetectConfig_A() const              { return sd_config >> 4; }                        ///< Same as PI3EQX12908::getSignalDetectConfig_A()
+  uint8_t getSignalDetectConfig_A(uint8_t index) const { return sd_config & (1 << (index + 4)); }        ///< Same as PI3EQX12908::getSignalDetectConfig_A(uint8_t)
+  uint8_t getSignalDetectConfig_B() const              { return sd_config & 0x0F; }                      ///< Same as PI3EQX12908::getSignalDetectConfig_B()
+  uint8_t getSignalDetectConfig_B(uint8_t index) const { return sd_config & (1 << index); }              ///< Same as PI3EQX12908::getSignalDetectConfig_B(uint8_t)
+  uint8_t getRxDetectConfig() const                    { return rx_config; }                             ///< Same as PI3EQX12908::getRxDetectConfig()
+  uint8_t getRxDetectConfig_A() const                  { return rx_config >> 4; }                        ///< Same as PI3EQX12908::getRxDetectConfig_A()
+  uint8_t getRxDetectConfig_A(uint8_t index) const     { return rx_config & (1 << (index + 4)); }        ///< Same as PI3EQX12908::getRxDetectConfig_A(uint8_t)
+  uint8_t getRxDetectConfig_B() const                  { return rx_config & 0x0F; }                      ///< Same as PI3EQX12908::getRxDetectConfig_B()
+  uint8_t getRxDetectConfig_B(uint8_t index) const     { return rx_config & (1 << index); }              ///< Same as PI3EQX12908::getRxDetectConfig_B(uint8_t)
+  LaneMask getSignalDetectMask(LaneMask lanes = LANES_ALL) const       { return signal_detect & lanes; } ///< Same as PI3EQX12908::getSignalDetectMask()
+  LaneMask getRxDetectMask(LaneMask lanes = LANES_ALL) const           { return rx_detect & lanes; }     ///< Same as PI3EQX12908::getRxDetectMask()
+  LaneMask getPowerDownMask(LaneMask lanes = LANES_ALL) const          { return power_down & lanes; }    ///< Same as PI3EQX12908::getPowerDownMask()
+  LaneMask getSignalDetectConfigMask(LaneMask lanes = LANES_ALL) const { return sd_config & lanes; }     ///< Same as PI3EQX12908::getSignalDetectConfigMask()
+  LaneMask getRxDetectConfigMask(LaneMask lanes = LANES_ALL) const     { return rx_config & lanes; }     ///< Same as PI3EQX12908::getRxDetectConfigMask()
+  uint8_t getSDTConfig() const                         { return sdt; }                                   ///< Decoded 2 bit signal detect threshold
+};
+
+#define FIELD_RO  0 ///< Read only field
+#define FIELD_RW  1 ///< Read/write field
+
+/*
+ * Register map
+ *
+ * Every field of the register map is described once in FIELD_TABLE
+ * (register, shift, width, access). PI3EQX12908::get<F>() and
+ * PI3EQX12908::set<F...>() read and write fields through it; the
+ * descriptors are only used at compile time and fold into plain
+ * shifts and masks.
+ */
+
+/**************************************************************************/
+/*! 
+    @brief  Fields of the register map, indexes into FIELD_TABLE
+*/
+/**************************************************************************/
+enum Field : uint8_t{
+  FIELD_SIGNAL_DETECT,
+  FIELD_SIGNAL_DETECT_A,
+  FIELD_SIGNAL_DETECT_B,
+  FIELD_SIGNAL_DETECT_A0,
+  FIELD_SIGNAL_DETECT_A1,
+  FIELD_SIGNAL_DETECT_A2,
+  FIELD_SIGNAL_DETECT_A3,
+  FIELD_SIGNAL_DETECT_B0,
+  FIELD_SIGNAL_DETECT_B1,
+  FIELD_SIGNAL_DETECT_B2,
+  FIELD_SIGNAL_DETECT_B3,
+  FIELD_RX_DETECT,
+  FIELD_RX_DETECT_A,
+  FIELD_RX_DETECT_B,
+  FIELD_RX_DETECT_A0,
+  FIELD_RX_DETECT_A1,
+  FIELD_RX_DETECT_A2,
+  FIELD_RX_DETECT_A3,
+  FIELD_RX_DETECT_B0,
+  FIELD_RX_DETECT_B1,
+  FIELD_RX_DETECT_B2,
+  FIELD_RX_DETECT_B3,
+  FIELD_POWER_DOWN,
+  FIELD_POWER_DOWN_A,
+  FIELD_POWER_DOWN_B,
+  FIELD_POWER_DOWN_A0,
+  FIELD_POWER_DOWN_A1,
+  FIELD_POWER_DOWN_A2,
+  FIELD_POWER_DOWN_A3,
+  FIELD_POWER_DOWN_B0,
+  FIELD_POWER_DOWN_B1,
+  FIELD_POWER_DOWN_B2,
+  FIELD_POWER_DOWN_B3,
+  FIELD_CONFIG_A0,
+  FIELD_EQ_A0,
+  FIELD_FG_A0,
+  FIELD_SW_A0,
+  FIELD_CONFIG_A1,
+  FIELD_EQ_A1,
+  FIELD_FG_A1,
+  FIELD_SW_A1,
+  FIELD_CONFIG_A2,
+  FIELD_EQ_A2,
+  FIELD_FG_A2,
+  FIELD_SW_A2,
+  FIELD_CONFIG_A3,
+  FIELD_EQ_A3,
+  FIELD_FG_A3,
+  FIELD_SW_A3,
+  FIELD_CONFIG_B0,
+  FIELD_EQ_B0,
+  FIELD_FG_B0,
+  FIELD_SW_B0,
+  FIELD_CONFIG_B1,
+  FIELD_EQ_B1,
+  FIELD_FG_B1,
+  FIELD_SW_B1,
+  FIELD_CONFIG_B2,
+  FIELD_EQ_B2,
+  FIELD_FG_B2,
+  FIELD_SW_B2,
+  FIELD_CONFIG_B3,
+  FIELD_EQ_B3,
+  FIELD_FG_B3,
+  FIELD_SW_B3,
+  FIELD_SIGNAL_DET_CFG,
+  FIELD_SIGNAL_DET_CFG_A,
+  FIELD_SIGNAL_DET_CFG_B,
+  FIELD_SIGNAL_DET_CFG_A0,
+  FIELD_SIGNAL_DET_CFG_A1,
+  FIELD_SIGNAL_DET_CFG_A2,
+  FIELD_SIGNAL_DET_CFG_A3,
+  FIELD_SIGNAL_DET_CFG_B0,
+  FIELD_SIGNAL_DET_CFG_B1,
+  FIELD_SIGNAL_DET_CFG_B2,
+  FIELD_SIGNAL_DET_CFG_B3,
+  FIELD_RX_DET_CFG,
+  FIELD_RX_DET_CFG_A,
+  FIELD_RX_DET_CFG_B,
+  FIELD_RX_DET_CFG_A0,
+  FIELD_RX_DET_CFG_A1,
+  FIELD_RX_DET_CFG_A2,
+  FIELD_RX_DET_CFG_A3,
+  FIELD_RX_DET_CFG_B0,
+  FIELD_RX_DET_CFG_B1,
+  FIELD_RX_DET_CFG_B2,
+  FIELD_RX_DET_CFG_B3,
+  FIELD_SDT,
+  FIELD_COUNT
+};
+/**************************************************************************/
+/*! 
+    @brief  Location and access of one field of the register map
+*/
+/**************************************************************************/
+struct FieldDesc{
+  uint8_t reg;     ///< Register address
+  uint8_t shift;   ///< Position of the lowest bit
+  uint8_t width;   ///< Number of bits
+  uint8_t access;  ///< #FIELD_RO or #FIELD_RW
+};
+
+constexpr FieldDesc FIELD_TABLE[FIELD_COUNT] = {
+  {SIGNAL_DETECT_REG,   0,         8, FIELD_RO}, // FIELD_SIGNAL_DETECT
+  {SIGNAL_DETECT_REG,   4,         4, FIELD_RO}, // FIELD_SIGNAL_DETECT_A
+  {SIGNAL_DETECT_REG,   0,         4, FIELD_RO}, // FIELD_SIGNAL_DETECT_B
+  {SIGNAL_DETECT_REG,   4,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_A0
+  {SIGNAL_DETECT_REG,   5,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_A1
+  {SIGNAL_DETECT_REG,   6,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_A2
+  {SIGNAL_DETECT_REG,   7,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_A3
+  {SIGNAL_DETECT_REG,   0,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_B0
+  {SIGNAL_DETECT_REG,   1,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_B1
+  {SIGNAL_DETECT_REG,   2,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_B2
+  {SIGNAL_DETECT_REG,   3,         1, FIELD_RO}, // FIELD_SIGNAL_DETECT_B3
+  {RX_DETECT_REG,       0,         8, FIELD_RO}, // FIELD_RX_DETECT
+  {RX_DETECT_REG,       4,         4, FIELD_RO}, // FIELD_RX_DETECT_A
+  {RX_DETECT_REG,       0,         4, FIELD_RO}, // FIELD_RX_DETECT_B
+  {RX_DETECT_REG,       4,         1, FIELD_RO}, // FIELD_RX_DETECT_A0
+  {RX_DETECT_REG,       5,         1, FIELD_RO}, // FIELD_RX_DETECT_A1
+  {RX_DETECT_REG,       6,         1, FIELD_RO}, // FIELD_RX_DETECT_A2
+  {RX_DETECT_REG,       7,         1, FIELD_RO}, // FIELD_RX_DETECT_A3
+  {RX_DETECT_REG,       0,         1, FIELD_RO}, // FIELD_RX_DETECT_B0
+  {RX_DETECT_REG,       1,         1, FIELD_RO}, // FIELD_RX_DETECT_B1
+  {RX_DETECT_REG,       2,         1, FIELD_RO}, // FIELD_RX_DETECT_B2
+  {RX_DETECT_REG,       3,         1, FIELD_RO}, // FIELD_RX_DETECT_B3
+  {POWER_DOWN_REG,      0,         8, FIELD_RW}, // FIELD_POWER_DOWN
+  {POWER_DOWN_REG,      4,         4, FIELD_RW}, // FIELD_POWER_DOWN_A
+  {POWER_DOWN_REG,      0,         4, FIELD_RW}, // FIELD_POWER_DOWN_B
+  {POWER_DOWN_REG,      4,         1, FIELD_RW}, // FIELD_POWER_DOWN_A0
+  {POWER_DOWN_REG,      5,         1, FIELD_RW}, // FIELD_POWER_DOWN_A1
+  {POWER_DOWN_REG,      6,         1, FIELD_RW}, // FIELD_POWER_DOWN_A2
+  {POWER_DOWN_REG,      7,         1, FIELD_RW}, // FIELD_POWER_DOWN_A3
+  {POWER_DOWN_REG,      0,         1, FIELD_RW}, // FIELD_POWER_DOWN_B0
+  {POWER_DOWN_REG,      1,         1, FIELD_RW}, // FIELD_POWER_DOWN_B1
+  {POWER_DOWN_REG,      2,         1, FIELD_RW}, // FIELD_POWER_DOWN_B2
+  {POWER_DOWN_REG,      3,         1, FIELD_RW}, // FIELD_POWER_DOWN_B3
+  {CONFIG_A0_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_A0
+  {CONFIG_A0_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_A0
+  {CONFIG_A0_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_A0
+  {CONFIG_A0_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_A0
+  {CONFIG_A1_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_A1
+  {CONFIG_A1_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_A1
+  {CONFIG_A1_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_A1
+  {CONFIG_A1_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_A1
+  {CONFIG_A2_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_A2
+  {CONFIG_A2_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_A2
+  {CONFIG_A2_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_A2
+  {CONFIG_A2_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_A2
+  {CONFIG_A3_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_A3
+  {CONFIG_A3_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_A3
+  {CONFIG_A3_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_A3
+  {CONFIG_A3_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_A3
+  {CONFIG_B0_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_B0
+  {CONFIG_B0_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_B0
+  {CONFIG_B0_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_B0
+  {CONFIG_B0_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_B0
+  {CONFIG_B1_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_B1
+  {CONFIG_B1_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_B1
+  {CONFIG_B1_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_B1
+  {CONFIG_B1_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_B1
+  {CONFIG_B2_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_B2
+  {CONFIG_B2_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_B2
+  {CONFIG_B2_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_B2
+  {CONFIG_B2_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_B2
+  {CONFIG_B3_REG,       0,         8, FIELD_RW}, // FIELD_CONFIG_B3
+  {CONFIG_B3_REG,       EQ_SHIFT,  4, FIELD_RW}, // FIELD_EQ_B3
+  {CONFIG_B3_REG,       FG_SHIFT,  2, FIELD_RW}, // FIELD_FG_B3
+  {CONFIG_B3_REG,       SW_SHIFT,  1, FIELD_RW}, // FIELD_SW_B3
+  {SIGNAL_DET_CFG_REG,  0,         8, FIELD_RW}, // FIELD_SIGNAL_DET_CFG
+  {SIGNAL_DET_CFG_REG,  4,         4, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_A
+  {SIGNAL_DET_CFG_REG,  0,         4, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_B
+  {SIGNAL_DET_CFG_REG,  4,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_A0
+  {SIGNAL_DET_CFG_REG,  5,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_A1
+  {SIGNAL_DET_CFG_REG,  6,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_A2
+  {SIGNAL_DET_CFG_REG,  7,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_A3
+  {SIGNAL_DET_CFG_REG,  0,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_B0
+  {SIGNAL_DET_CFG_REG,  1,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_B1
+  {SIGNAL_DET_CFG_REG,  2,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_B2
+  {SIGNAL_DET_CFG_REG,  3,         1, FIELD_RW}, // FIELD_SIGNAL_DET_CFG_B3
+  {RX_DET_CFG_REG,      0,         8, FIELD_RW}, // FIELD_RX_DET_CFG
+  {RX_DET_CFG_REG,      4,         4, FIELD_RW}, // FIELD_RX_DET_CFG_A
+  {RX_DET_CFG_REG,      0,         4, FIELD_RW}, // FIELD_RX_DET_CFG_B
+  {RX_DET_CFG_REG,      4,         1, FIELD_RW}, // FIELD_RX_DET_CFG_A0
+  {RX_DET_CFG_REG,      5,         1, FIELD_RW}, // FIELD_RX_DET_CFG_A1
+  {RX_DET_CFG_REG,      6,         1, FIELD_RW}, // FIELD_RX_DET_CFG_A2
+  {RX_DET_CFG_REG,      7,         1, FIELD_RW}, // FIELD_RX_DET_CFG_A3
+  {RX_DET_CFG_REG,      0,         1, FIELD_RW}, // FIELD_RX_DET_CFG_B0
+  {RX_DET_CFG_REG,      1,         1, FIELD_RW}, // FIELD_RX_DET_CFG_B1
+  {RX_DET_CFG_REG,      2,         1, FIELD_RW}, // FIELD_RX_DET_CFG_B2
+  {RX_DET_CFG_REG,      3,         1, FIELD_RW}, // FIELD_RX_DET_CFG_B3
+  {SIGNAL_DET_TH_REG,   SDT_SHIFT, 2, FIELD_RW}, // FIELD_SDT
+};
+
+static_assert(sizeof(FIELD_TABLE) / sizeof(FIELD_TABLE[0]) == FIELD_COUNT, "FIELD_TABLE does not match Field");
+
+/**************************************************************************/
+/*! 
+    @brief  Compile-time view of one FIELD_TABLE entry
+*/
+/**************************************************************************/
+template <uint8_t F>
+struct FieldInfo{
+  static_assert(F < FIELD_COUNT, "Unknown field");
+  static constexpr uint8_t reg      = FIELD_TABLE[F].reg;                                             ///< Register address
+  static constexpr uint8_t shift    = FIELD_TABLE[F].shift;                                           ///< Position of the lowest bit
+  static constexpr uint8_t mask     = ((1 << FIELD_TABLE[F].width) - 1) << FIELD_TABLE[F].shift;      ///< Field mask in the register
+  static constexpr bool    writable = FIELD_TABLE[F].access == FIELD_RW;                              ///< false for read only fields
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Combined view of several fields of the same register
+*/
+/**************************************************************************/
+template <uint8_t... F>
+struct FieldSet;
+
+template <uint8_t F>
+struct FieldSet<F>{
+  static constexpr uint8_t reg      = FieldInfo<F>::reg;
+  static constexpr uint8_t mask     = FieldInfo<F>::mask;
+  static constexpr bool    writable = FieldInfo<F>::writable;
+};
+
+template <uint8_t F, uint8_t... Rest>
+struct FieldSet<F, Rest...>{
+  static_assert(FieldInfo<F>::reg == FieldSet<Rest...>::reg, "All fields of one set<>() call must be in the same register");
+  static constexpr uint8_t reg      = FieldInfo<F>::reg;
+  static constexpr uint8_t mask     = FieldInfo<F>::mask | FieldSet<Rest...>::mask;
+  static constexpr bool    writable = FieldInfo<F>::writable && FieldSet<Rest...>::writable;
+};
+
+/*! @brief Argument type of set<F...>(), one uint8_t per field */
+template <uint8_t F>
+struct FieldArg{
+  typedef uint8_t type;
+};
+
+class PI3EQX12908;
+class Print;
+struct RedriverProfile;
+
+/**************************************************************************/
+/*! 
+    @brief  Pending change of one channel config register
+            Returned by the fluent ChannelRef setters. All chained changes
+            are folded into a single register write when the object goes
+            out of scope (at the end of the statement) or on apply().
+*/
+/**************************************************************************/
+class ChannelUpdate{
+  public:
+    ChannelUpdate(PI3EQX12908& rd, uint8_t mem_addr) : _rd(&rd), _reg(mem_addr), _mask(0), _value(0) {}
+    ChannelUpdate(ChannelUpdate&& other) : _rd(other._rd), _reg(other._reg), _mask(other._mask), _value(other._value) { other._mask = 0; }
+    ~ChannelUpdate() { apply(); }
+
+    ChannelUpdate& eq(uint8_t EQ)          { return _set(EQ_MASK, EQ << EQ_SHIFT); }          ///< Sets the equalizer index
+    ChannelUpdate& gain(uint8_t flat_gain) { return _set(FG_MASK, flat_gain << FG_SHIFT); }   ///< Sets the flat gain
+    ChannelUpdate& swing(uint8_t swing)    { return _set(SW_MASK, swing << SW_SHIFT); }       ///< Sets the swing
+    void apply();
+
+  private:
+    PI3EQX12908* _rd;
+    uint8_t      _reg;
+    uint8_t      _mask;
+    uint8_t      _value;
+
+    ChannelUpdate(const ChannelUpdate&);
+    ChannelUpdate& operator=(const ChannelUpdate&);
+    ChannelUpdate& _set(uint8_t mask, uint8_t value) { _mask |= mask; _value = (_value & ~mask) | (value & mask); return *this; }
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Runtime handle to one channel (bank and index)
+            Gives access to the channel config register and to the
+            channel bit of the bit-per-lane registers.
+*/
+/**************************************************************************/
+class ChannelRef{
+  public:
+    ChannelRef(PI3EQX12908& rd, uint8_t bank, uint8_t index)
+      : _rd(&rd),
+        _reg((bank == BANK_A ? CONFIG_A_OFFSET : CONFIG_B_OFFSET) + index),
+        _mask(bank == BANK_A ? 1 << (index + 4) : 1 << index) {}
+
+    uint8_t reg() const  { return _reg; }   ///< Address of the channel config register
+    uint8_t mask() const { return _mask; }  ///< Channel bit in the bit-per-lane registers
+
+    uint8_t getConfig();
+    uint8_t getEQ();
+    uint8_t getFlatGain();
+    uint8_t getSW();
+    void setConfig(uint8_t config);
+    ChannelUpdate eq(uint8_t EQ);
+    ChannelUpdate gain(uint8_t flat_gain);
+    ChannelUpdate swing(uint8_t swing);
+
+    uint8_t getSignalDetect();
+    uint8_t getRxDetect();
+    uint8_t getPowerDown();
+    uint8_t getSignalDetectConfig();
+    uint8_t getRxDetectConfig();
+    void setPowerDown(uint8_t isDown);
+    void setSignalDetectConfig(uint8_t isDown);
+    void setRxDetectConfig(uint8_t isDown);
+
+  protected:
+    PI3EQX12908* _rd;
+    uint8_t      _reg;
+    uint8_t      _mask;
+};
+
+template <uint8_t Bank, uint8_t Index>
+class Channel;
+
 /**************************************************************************/
 /*! 
     @brief  Class that stores state and functions for interacting with PI3EQX12908A2
@@ -74,7 +571,48 @@
 /**************************************************************************/
 class PI3EQX12908{
   public:
-    init(uint8_t i2c_addr);
+#ifdef PI3EQX12908_WIRE_BUS
+    void init(uint8_t i2c_addr, bool use_cache = false);
+#endif
+    void init(uint8_t i2c_addr, PI3EQX12908_BUS& bus, bool use_cache = false);
+
+    // Shadow cache
+    void setCache(bool enable);
+    void resync();
+    void invalidate();
+
+    void setRetry(uint8_t retries, uint16_t backoff_us);
+    bool recover();
+    uint8_t lastError() const { return _last_error; }       ///< Status of the last bus access, one of the BUS_* codes
+    uint16_t errorCount() const { return _errors; }         ///< Number of bus accesses that failed after all retries
+    uint32_t worstLatency() const { return _worst_us; }     ///< Longest bus access so far in us, retries included
+    void resetErrors() { _last_error = BUS_OK; _errors = 0; _worst_us = 0; } ///< Clears lastError(), errorCount() and worstLatency()
+
+    // Transaction
+    void beginTransaction();
+    uint8_t commit();
+
+    // Read planner
+    void prefetch(uint16_t mask);
+    uint8_t read(uint16_t mask, uint8_t* data);
+
+    // Channel handles
+    template <uint8_t Bank, uint8_t Index>
+    Channel<Bank, Index> channel() { return Channel<Bank, Index>(*this); }
+    ChannelRef channel(uint8_t bank, uint8_t index);
+
+    // Generic field access
+    /*! @brief Reads one field of FIELD_TABLE, e.g. get<FIELD_EQ_A0>() */
+    template <uint8_t F>
+    uint8_t get() { return (_read_reg(FieldInfo<F>::reg) & FieldInfo<F>::mask) >> FieldInfo<F>::shift; }
+
+    /*! @brief Writes one or more fields of the same register in one write,
+               e.g. set<FIELD_EQ_A0, FIELD_FG_A0>(5, FLAT_GAIN_00db) */
+    template <uint8_t... F>
+    void set(typename FieldArg<F>::type... values){
+      static_assert(FieldSet<F...>::writable, "Field is read only");
+      _update_reg(FieldSet<F...>::reg, FieldSet<F...>::mask, _pack<F...>(values...));
+    }
 
     // 0 - Signal Detect
     uint8_t getSignalDetect();
@@ -208,7 +746,18 @@ class PI3EQX12908{
 
     // 13 - Signal Detect Threshold
     uint8_t getSDTConfig();
-    uint8_t setSDTConfig(uint8_t thresh);
+    void setSDTConfig(uint8_t thresh);
+    uint8_t estimateAmplitude(uint16_t* low_mVpp, uint16_t* high_mVpp, uint16_t settle_us = 0);
+
+    // Lane masks
+    LaneMask getSignalDetectMask(LaneMask lanes = LANES_ALL);
+    LaneMask getRxDetectMask(LaneMask lanes = LANES_ALL);
+    LaneMask getPowerDownMask(LaneMask lanes = LANES_ALL);
+    LaneMask getSignalDetectConfigMask(LaneMask lanes = LANES_ALL);
+    LaneMask getRxDetectConfigMask(LaneMask lanes = LANES_ALL);
+    void setPowerDownMask(LaneMask lanes, uint8_t isDown);
+    void setSignalDetectConfigMask(LaneMask lanes, uint8_t isDown);
+    void setRxDetectConfigMask(LaneMask lanes, uint8_t isDown);
 
     // Others
     void setConfig_A(uint8_t config);
@@ -226,16 +775,121 @@ class PI3EQX12908{
     void setSW_B(uint8_t swing);
     void setSW(uint8_t swing);
     void print_all();
+    void print_all(Print& out, uint8_t format);
+    static const char* regName(uint8_t mem_addr);
     void dump_all(uint8_t* data);
+    void snapshot(RedriverState& state);
+    void readImage(uint8_t* image);
+    uint8_t writeImage(const uint8_t* image);
+    uint8_t writeImage_P(const uint8_t* image);
+    void applyProfile(const RedriverProfile& profile);
+    void captureProfile(RedriverProfile& profile);
+    uint8_t apply(const RedriverState& desired, uint8_t* count = NULL);
 
   private:
+    friend class ChannelRef;
+    friend class ChannelUpdate;
+    template <uint8_t Bank, uint8_t Index> friend class Channel;
+    friend class PI3EQX12908Async;
+    friend class SweepEngine;
+    friend class DriftWatchdog;
+    friend class RedriverFleet;
+    friend class LanePowerPolicy;
+
     uint8_t  _I2C_ADDR;
-    String _REGS[16];
+    PI3EQX12908_BUS* _bus;
+
+    bool     _cache_enabled;
+    bool     _shadow_valid;
+    bool     _in_txn;
+    uint16_t _dirty;
+    uint16_t _rx_pending;
+    uint8_t  _rx[REG_COUNT];
+    uint8_t  _shadow[SHADOW_LEN];
+
+    uint8_t  _retries;
+    uint16_t _backoff_us;
+    uint8_t  _last_error;
+    uint16_t _errors;
+    uint32_t _worst_us;
 
     uint8_t _read_reg(uint8_t mem_addr);
-    void _write_reg(uint8_t mem_addr, uint8_t value);
-    void _burst_read(uint8_t mem_addr, uint8_t* data, uint8_t len);
-    void _burst_write(uint8_t mem_addr, uint8_t* data, uint8_t len);
+    uint8_t _write_reg(uint8_t mem_addr, uint8_t value);
+    uint8_t _burst_read(uint8_t mem_addr, uint8_t* data, uint8_t len);
+    uint8_t _burst_write(uint8_t mem_addr, uint8_t* data, uint8_t len);
+    uint8_t _update_reg(uint8_t mem_addr, uint8_t mask, uint8_t value);
+    uint8_t _write_runs(uint16_t dirty, uint8_t* image, uint8_t& count, uint8_t max_gap = WRITE_MERGE_GAP);
+
+    // Sets field F (of the first channel) in count channel config
+    // registers with one read and one write; never writes back a failed read
+    template <uint8_t F>
+    void _set_channels(uint8_t count, uint8_t value){
+      static_assert(FieldInfo<F>::writable && FieldInfo<F>::reg >= CONFIG_A0_REG && FieldInfo<F>::reg <= CONFIG_B3_REG, "Not a channel config field");
+      uint8_t val[8];
+      if(_burst_read(FieldInfo<F>::reg, val, count) != BUS_OK)
+        return;
+      for(uint8_t i=0; i<count; i++)
+        val[i] = (val[i] & ~FieldInfo<F>::mask) | _pack<F>(value);
+      _burst_write(FieldInfo<F>::reg, val, count);
+    }
+    template <uint8_t F>
+    static constexpr uint8_t _pack(uint8_t value) { return (value << FieldInfo<F>::shift) & FieldInfo<F>::mask; }
+    template <uint8_t F, uint8_t G, uint8_t... Rest>
+    static constexpr uint8_t _pack(uint8_t value, uint8_t next, typename FieldArg<Rest>::type... rest){
+      return _pack<F>(value) | _pack<G, Rest...>(next, rest...);
+    }
+    void _patch_rx(uint8_t mem_addr, const uint8_t* data, uint8_t len);
+    void _load_shadow(const uint8_t* image);
+    bool _shadow_ready(uint8_t mem_addr, uint8_t len);
+    uint8_t _bus_read(uint8_t mem_addr, uint8_t* data, uint8_t len);
+    uint8_t _bus_write(uint8_t mem_addr, uint8_t* data, uint8_t len);
+    void _retry_wait(uint8_t status, uint8_t attempt);
+    uint8_t _account(uint8_t status, unsigned long start);
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Compile-time handle to one channel
+            Same API as ChannelRef, but the register address and lane
+            mask are constants, so every call compiles to a register
+            access with fixed arguments.
+*/
+/**************************************************************************/
+template <uint8_t Bank, uint8_t Index>
+class Channel{
+  static_assert(Bank <= BANK_B, "Bank must be BANK_A or BANK_B");
+  static_assert(Index < 4, "Channel index must be 0 to 3");
+
+  public:
+    static constexpr uint8_t REG  = (Bank == BANK_A ? CONFIG_A_OFFSET : CONFIG_B_OFFSET) + Index; ///< Config register
+    static constexpr uint8_t MASK = Bank == BANK_A ? 1 << (Index + 4) : 1 << Index;               ///< Lane bit
+
+    explicit Channel(PI3EQX12908& rd) : _rd(&rd) {}
+    operator ChannelRef() const { return ChannelRef(*_rd, Bank, Index); } ///< Runtime handle to the same channel
+
+    uint8_t reg() const  { return REG; }   ///< Address of the channel config register
+    uint8_t mask() const { return MASK; }  ///< Channel bit in the bit-per-lane registers
+
+    uint8_t getConfig()   { return _rd->_read_reg(REG); }                             ///< See ChannelRef::getConfig()
+    uint8_t getEQ()       { return (_rd->_read_reg(REG) & EQ_MASK) >> EQ_SHIFT; }     ///< See ChannelRef::getEQ()
+    uint8_t getFlatGain() { return (_rd->_read_reg(REG) & FG_MASK) >> FG_SHIFT; }     ///< See ChannelRef::getFlatGain()
+    uint8_t getSW()       { return (_rd->_read_reg(REG) & SW_MASK) >> SW_SHIFT; }     ///< See ChannelRef::getSW()
+    void setConfig(uint8_t config) { _rd->_write_reg(REG, config); }                  ///< See ChannelRef::setConfig()
+    ChannelUpdate eq(uint8_t EQ)          { ChannelUpdate update(*_rd, REG); update.eq(EQ); return update; }          ///< See ChannelRef::eq()
+    ChannelUpdate gain(uint8_t flat_gain) { ChannelUpdate update(*_rd, REG); update.gain(flat_gain); return update; } ///< See ChannelRef::gain()
+    ChannelUpdate swing(uint8_t swing)    { ChannelUpdate update(*_rd, REG); update.swing(swing); return update; }    ///< See ChannelRef::swing()
+
+    uint8_t getSignalDetect()       { return _rd->_read_reg(SIGNAL_DETECT_REG) & MASK; }                       ///< See ChannelRef::getSignalDetect()
+    uint8_t getRxDetect()           { return _rd->_read_reg(RX_DETECT_REG) & MASK; }                           ///< See ChannelRef::getRxDetect()
+    uint8_t getPowerDown()          { return _rd->_read_reg(POWER_DOWN_REG) & MASK; }                          ///< See ChannelRef::getPowerDown()
+    uint8_t getSignalDetectConfig() { return _rd->_read_reg(SIGNAL_DET_CFG_REG) & MASK; }                      ///< See ChannelRef::getSignalDetectConfig()
+    uint8_t getRxDetectConfig()     { return _rd->_read_reg(RX_DET_CFG_REG) & MASK; }                          ///< See ChannelRef::getRxDetectConfig()
+    void setPowerDown(uint8_t isDown)          { _rd->_update_reg(POWER_DOWN_REG, MASK, isDown ? 0xFF : 0x00); }     ///< See ChannelRef::setPowerDown()
+    void setSignalDetectConfig(uint8_t isDown) { _rd->_update_reg(SIGNAL_DET_CFG_REG, MASK, isDown ? 0xFF : 0x00); } ///< See ChannelRef::setSignalDetectConfig()
+    void setRxDetectConfig(uint8_t isDown)     { _rd->_update_reg(RX_DET_CFG_REG, MASK, isDown ? 0xFF : 0x00); }     ///< See ChannelRef::setRxDetectConfig()
+
+  private:
+    PI3EQX12908* _rd;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,212 @@
+/*!
+ * @file PI3EQX12908Async.cpp
+ *
+ * Poll-driven access to a PI3EQX12908.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "PI3EQX12908Async.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates an idle handle for a redriver
+    @param  rd
+            An initialized redriver.
+*/
+/**************************************************************************/
+PI3EQX12908Async::PI3EQX12908Async(PI3EQX12908& rd) : _rd(&rd), _op(ASYNC_IDLE), _status(BUS_OK){
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts reading all registers
+            Takes a single step.
+    @param  data
+            A pointer to an array of #REG_DUMP_LEN bytes, valid until
+            the operation completes.
+    @param  cb
+            Optional completion callback.
+    @param  arg
+            Argument passed to the callback.
+    @return false if another operation is running.
+*/
+/**************************************************************************/
+bool PI3EQX12908Async::startDumpAll(uint8_t* data, Callback cb, void* arg){
+  if(!_start(ASYNC_DUMP, cb, arg))
+    return false;
+  _data = data;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts writing a full configuration
+            Registers #POWER_DOWN_REG to #SIGNAL_DET_TH_REG are written
+            #ASYNC_MAX_WRITE bytes per step. The state is copied, so it
+            does not need to outlive the call.
+    @param  state
+            The configuration to write.
+    @param  cb
+            Optional completion callback.
+    @param  arg
+            Argument passed to the callback.
+    @return false if another operation is running.
+*/
+/**************************************************************************/
+bool PI3EQX12908Async::startApply(const RedriverState& state, Callback cb, void* arg){
+  if(!_start(ASYNC_APPLY, cb, arg))
+    return false;
+  state.encode(_buf);
+  _pos = SHADOW_FIRST_REG;
+  _end = SHADOW_LAST_REG + 1;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Starts setting the equalizer of all channels
+            The first step reads the config registers, the next ones
+            write them back #ASYNC_MAX_WRITE bytes at a time.
+    @param  EQ
+            4 bit value of the equalizer index
+    @param  cb
+            Optional completion callback.
+    @param  arg
+            Argument passed to the callback.
+    @return false if another operation is running.
+*/
+/**************************************************************************/
+bool PI3EQX12908Async::startSetEQ(uint8_t EQ, Callback cb, void* arg){
+  if(!_start(ASYNC_SET_EQ, cb, arg))
+    return false;
+  _value = EQ;
+  _pos = CONFIG_A0_REG;
+  _end = CONFIG_B3_REG + 1;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Advances the running operation by one step
+    @return true while the operation is still running.
+*/
+/**************************************************************************/
+bool PI3EQX12908Async::poll(){
+  if(_op == ASYNC_IDLE)
+    return false;
+  if(_waiting){
+    if(_recover){
+      _recover = false;
+      _rd->_bus->recover();
+      _wait_start = micros();
+      return true;
+    }
+    if(micros() - _wait_start < _wait_us)
+      return true;
+    _waiting = false;
+  }
+  // One attempt per step, the driver's own retry loop would block
+  uint8_t retries = _rd->_retries;
+  _rd->_retries = 0;
+  bool running = _run_step();
+  _rd->_retries = retries;
+  if(_status != BUS_OK){
+    if(_schedule_retry())
+      return true;
+    running = false;
+  }
+  else
+    _attempt = 0;
+  if(!running)
+    _finish();
+  return busy();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Abandons the running operation
+            Registers already written keep their new value and the
+            callback is not called.
+*/
+/**************************************************************************/
+void PI3EQX12908Async::cancel(){
+  _op = ASYNC_IDLE;
+}
+
+bool PI3EQX12908Async::_start(uint8_t op, Callback cb, void* arg){
+  if(busy())
+    return false;
+  _op = op;
+  _status = BUS_OK;
+  _step = 0;
+  _attempt = 0;
+  _waiting = false;
+  _recover = false;
+  _cb = cb;
+  _arg = arg;
+  return true;
+}
+
+// Runs one attempt of the current step, returns false when the operation
+// has nothing left to do. _status holds the result of the attempt.
+bool PI3EQX12908Async::_run_step(){
+  switch(_op){
+    case ASYNC_DUMP:
+      _status = _rd->_burst_read(0, _data, REG_DUMP_LEN);
+      return false;
+
+    case ASYNC_APPLY:
+      return _write_step();
+
+    case ASYNC_SET_EQ:
+      if(_step == 0){
+        _status = _rd->_burst_read(CONFIG_A0_REG, &_buf[CONFIG_A0_REG], 8);
+        if(_status != BUS_OK)
+          return true;
+        for(uint8_t i=CONFIG_A0_REG; i<=CONFIG_B3_REG; i++)
+          _buf[i] = (_buf[i] & ~EQ_MASK) | ((_value << EQ_SHIFT) & EQ_MASK);
+        _step++;
+        return true;
+      }
+      return _write_step();
+
+    default:
+      return false;
+  }
+}
+
+bool PI3EQX12908Async::_write_step(){
+  if(_pos >= _end)
+    return false;
+  uint8_t len = _end - _pos;
+  if(len > ASYNC_MAX_WRITE)
+    len = ASYNC_MAX_WRITE;
+  _status = _rd->_burst_write(_pos, &_buf[_pos], len);
+  // A failed chunk is written again by the retry
+  if(_status == BUS_OK)
+    _pos += len;
+  return _pos < _end;
+}
+
+// Mirrors PI3EQX12908::_retry_wait(), spread over the following polls
+bool PI3EQX12908Async::_schedule_retry(){
+  if(_attempt >= _rd->_retries)
+    return false;
+  _recover = _status == BUS_ERR_TIMEOUT || _status == BUS_ERR_OTHER;
+  _wait_us = (uint32_t)_rd->_backoff_us << _attempt;
+  _wait_start = micros();
+  _attempt++;
+  _waiting = true;
+  return true;
+}
+
+void PI3EQX12908Async::_finish(){
+  _op = ASYNC_IDLE;
+  if(_cb)
+    _cb(*this, _arg);
+}
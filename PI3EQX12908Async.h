@@ -0,0 +1,84 @@
+/*!
+ * @file PI3EQX12908Async.h
+ *
+ * Poll-driven access to a PI3EQX12908. Long operations are split into
+ * steps of at most one short bus transaction, so the main loop keeps
+ * running between them.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _PI3EQX12908_ASYNC_H
+#define _PI3EQX12908_ASYNC_H
+
+#include "PI3EQX12908A2.h"
+
+#ifndef ASYNC_MAX_WRITE
+#define ASYNC_MAX_WRITE 4 ///< Register bytes written per step
+#endif
+
+#define ASYNC_IDLE    0 ///< No operation running
+#define ASYNC_DUMP    1 ///< startDumpAll() running
+#define ASYNC_APPLY   2 ///< startApply() running
+#define ASYNC_SET_EQ  3 ///< startSetEQ() running
+
+/**************************************************************************/
+/*! 
+    @brief  Handle of a non-blocking operation on one redriver
+            Start an operation with one of the start functions, then call
+            poll() from loop() until it returns false. Each poll() runs
+            at most one bus transaction: a read of up to #REG_DUMP_LEN
+            bytes or a write of up to #ASYNC_MAX_WRITE register bytes.
+            A step makes a single attempt; a failed one is repeated on
+            later polls with the retry policy of the driver (see
+            PI3EQX12908::setRetry()). The bus recovery and the backoff
+            wait take polls of their own instead of blocking one.
+            The callback runs when the operation is complete, or when a
+            step has failed all its retries; status() tells which.
+*/
+/**************************************************************************/
+class PI3EQX12908Async{
+  public:
+    /*! @brief Completion callback */
+    typedef void (*Callback)(PI3EQX12908Async& op, void* arg);
+
+    PI3EQX12908Async(PI3EQX12908& rd);
+
+    bool startDumpAll(uint8_t* data, Callback cb = NULL, void* arg = NULL);
+    bool startApply(const RedriverState& state, Callback cb = NULL, void* arg = NULL);
+    bool startSetEQ(uint8_t EQ, Callback cb = NULL, void* arg = NULL);
+    bool poll();
+    void cancel();
+    bool busy() const { return _op != ASYNC_IDLE; }
+    uint8_t status() const { return _status; }  ///< BUS_* code of the last operation, valid in the callback
+    uint8_t operation() const { return _op; }
+
+  private:
+    PI3EQX12908* _rd;
+    uint8_t      _op;
+    uint8_t      _status;
+    uint8_t      _step;
+    uint8_t      _pos;
+    uint8_t      _end;
+    uint8_t      _value;
+    uint8_t      _attempt;
+    bool         _waiting;
+    bool         _recover;
+    uint32_t     _wait_us;
+    unsigned long _wait_start;
+    uint8_t*     _data;
+    Callback     _cb;
+    void*        _arg;
+    uint8_t      _buf[REG_COUNT];
+
+    bool _start(uint8_t op, Callback cb, void* arg);
+    bool _run_step();
+    bool _write_step();
+    bool _schedule_retry();
+    void _finish();
+};
+
+#endif
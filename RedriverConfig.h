@@ -0,0 +1,140 @@
+/*!
+ * @file RedriverConfig.h
+ *
+ * Compile-time builder for the PI3EQX12908 register image.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_CONFIG_H
+#define _REDRIVER_CONFIG_H
+
+#include "PI3EQX12908A2.h"
+
+/**************************************************************************/
+/*! 
+    @brief  constexpr builder of registers 2 to 13
+            Every value is a template argument checked by static_assert,
+            so a whole configuration folds into constant bytes:
+            @code
+            constexpr RedriverConfig CFG = RedriverConfig()
+              .eqAll<0>().fgAll<FLAT_GAIN_00db>().swAll<SWING_900mVpp>()
+              .sdt<SDT_OFF_30_ON_130_mVpp>();
+            const uint8_t IMAGE[SHADOW_LEN] PROGMEM = REDRIVER_CONFIG_IMAGE(CFG);
+            RD.writeImage_P(IMAGE);
+            @endcode
+            Bits that are not set through the builder, including the
+            reserved bit 1 of the config registers, are 0.
+*/
+/**************************************************************************/
+class RedriverConfig{
+  public:
+    uint8_t image[SHADOW_LEN]; ///< Registers #POWER_DOWN_REG to #SIGNAL_DET_TH_REG
+
+    constexpr RedriverConfig() : image{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0} {}
+
+    /*! @brief Value of a register of the image */
+    constexpr uint8_t reg(uint8_t mem_addr) const { return image[mem_addr - SHADOW_FIRST_REG]; }
+
+    /*! @brief Sets the EQ of one channel */
+    template<uint8_t Bank, uint8_t Index, uint8_t EQ>
+    constexpr RedriverConfig eq() const {
+      static_assert(Bank <= BANK_B && Index < 4, "Channel out of range");
+      static_assert(EQ < 16, "EQ out of range");
+      return _with(_config_reg(Bank, Index), _config_reg(Bank, Index), EQ_MASK, EQ << EQ_SHIFT);
+    }
+
+    /*! @brief Sets the flat gain of one channel */
+    template<uint8_t Bank, uint8_t Index, uint8_t FlatGain>
+    constexpr RedriverConfig fg() const {
+      static_assert(Bank <= BANK_B && Index < 4, "Channel out of range");
+      static_assert(FlatGain <= FLAT_GAIN_P2db, "Flat gain out of range");
+      return _with(_config_reg(Bank, Index), _config_reg(Bank, Index), FG_MASK, FlatGain << FG_SHIFT);
+    }
+
+    /*! @brief Sets the swing of one channel */
+    template<uint8_t Bank, uint8_t Index, uint8_t Swing>
+    constexpr RedriverConfig sw() const {
+      static_assert(Bank <= BANK_B && Index < 4, "Channel out of range");
+      static_assert(Swing <= SWING_1000mVpp, "Swing out of range");
+      return _with(_config_reg(Bank, Index), _config_reg(Bank, Index), SW_MASK, Swing << SW_SHIFT);
+    }
+
+    /*! @brief Sets the EQ of all channels */
+    template<uint8_t EQ>
+    constexpr RedriverConfig eqAll() const {
+      static_assert(EQ < 16, "EQ out of range");
+      return _with(CONFIG_A0_REG, CONFIG_B3_REG, EQ_MASK, EQ << EQ_SHIFT);
+    }
+
+    /*! @brief Sets the flat gain of all channels */
+    template<uint8_t FlatGain>
+    constexpr RedriverConfig fgAll() const {
+      static_assert(FlatGain <= FLAT_GAIN_P2db, "Flat gain out of range");
+      return _with(CONFIG_A0_REG, CONFIG_B3_REG, FG_MASK, FlatGain << FG_SHIFT);
+    }
+
+    /*! @brief Sets the swing of all channels */
+    template<uint8_t Swing>
+    constexpr RedriverConfig swAll() const {
+      static_assert(Swing <= SWING_1000mVpp, "Swing out of range");
+      return _with(CONFIG_A0_REG, CONFIG_B3_REG, SW_MASK, Swing << SW_SHIFT);
+    }
+
+    /*! @brief Sets the power down register (lane bits, 1 = powered down) */
+    template<uint8_t Lanes>
+    constexpr RedriverConfig powerDown() const {
+      return _with(POWER_DOWN_REG, POWER_DOWN_REG, 0xFF, Lanes);
+    }
+
+    /*! @brief Sets the signal detect config register (lane bits, 1 = powered down) */
+    template<uint8_t Lanes>
+    constexpr RedriverConfig signalDetectConfig() const {
+      return _with(SIGNAL_DET_CFG_REG, SIGNAL_DET_CFG_REG, 0xFF, Lanes);
+    }
+
+    /*! @brief Sets the RX detect config register (lane bits, 1 = powered down) */
+    template<uint8_t Lanes>
+    constexpr RedriverConfig rxDetectConfig() const {
+      return _with(RX_DET_CFG_REG, RX_DET_CFG_REG, 0xFF, Lanes);
+    }
+
+    /*! @brief Sets the signal detect threshold */
+    template<uint8_t Threshold>
+    constexpr RedriverConfig sdt() const {
+      static_assert(Threshold <= SDT_OFF_110_ON_210_mVpp, "Signal detect threshold out of range");
+      return _with(SIGNAL_DET_TH_REG, SIGNAL_DET_TH_REG, SDT_MASK, Threshold << SDT_SHIFT);
+    }
+
+  private:
+    constexpr RedriverConfig(uint8_t r2, uint8_t r3, uint8_t r4, uint8_t r5, uint8_t r6, uint8_t r7,
+                             uint8_t r8, uint8_t r9, uint8_t r10, uint8_t r11, uint8_t r12, uint8_t r13)
+      : image{r2, r3, r4, r5, r6, r7, r8, r9, r10, r11, r12, r13} {}
+
+    static constexpr uint8_t _config_reg(uint8_t bank, uint8_t index){
+      return (bank == BANK_A ? CONFIG_A_OFFSET : CONFIG_B_OFFSET) + index;
+    }
+
+    constexpr uint8_t _at(uint8_t mem_addr, uint8_t first, uint8_t last, uint8_t mask, uint8_t value) const {
+      return (mem_addr >= first && mem_addr <= last) ? (uint8_t)((reg(mem_addr) & ~mask) | (value & mask)) : reg(mem_addr);
+    }
+
+    constexpr RedriverConfig _with(uint8_t first, uint8_t last, uint8_t mask, uint8_t value) const {
+      return RedriverConfig(_at(2, first, last, mask, value), _at(3, first, last, mask, value),
+                            _at(4, first, last, mask, value), _at(5, first, last, mask, value),
+                            _at(6, first, last, mask, value), _at(7, first, last, mask, value),
+                            _at(8, first, last, mask, value), _at(9, first, last, mask, value),
+                            _at(10, first, last, mask, value), _at(11, first, last, mask, value),
+                            _at(12, first, last, mask, value), _at(13, first, last, mask, value));
+    }
+};
+
+/*! @brief Initializer of a #SHADOW_LEN byte array (for example in PROGMEM) from a constexpr RedriverConfig */
+#define REDRIVER_CONFIG_IMAGE(cfg) { \
+  (cfg).reg(2), (cfg).reg(3), (cfg).reg(4), (cfg).reg(5), (cfg).reg(6), (cfg).reg(7), \
+  (cfg).reg(8), (cfg).reg(9), (cfg).reg(10), (cfg).reg(11), (cfg).reg(12), (cfg).reg(13) }
+
+#endif
@@ -0,0 +1,35 @@
+/*!
+ * @file RedriverCrc.cpp
+ *
+ * CRC-16 used by the PI3EQX12908 profile and watchdog code.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "RedriverCrc.h"
+
+/**************************************************************************/
+/*!
+    @brief  Computes a CRC-16/CCITT (polynomial 0x1021) over a buffer
+            Bitwise, so it needs no table in flash. Pass the result of
+            a previous call as crc to continue over several buffers.
+    @param  data
+            A pointer to the data.
+    @param  len
+            Number of bytes.
+    @param  crc
+            Starting value.
+    @return The updated CRC.
+*/
+/**************************************************************************/
+uint16_t redriverCrc16(const uint8_t* data, uint16_t len, uint16_t crc){
+  while(len--){
+    crc ^= (uint16_t)*data++ << 8;
+    for(uint8_t i=0; i<8; i++)
+      crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+  }
+  return crc;
+}
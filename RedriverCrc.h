@@ -0,0 +1,21 @@
+/*!
+ * @file RedriverCrc.h
+ *
+ * CRC-16 used by the PI3EQX12908 profile code.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_CRC_H
+#define _REDRIVER_CRC_H
+
+#include <stdint.h>
+
+#define REDRIVER_CRC_INIT 0xFFFF ///< Initial value of redriverCrc16()
+
+uint16_t redriverCrc16(const uint8_t* data, uint16_t len, uint16_t crc = REDRIVER_CRC_INIT);
+
+#endif
@@ -0,0 +1,147 @@
+/*!
+ * @file RedriverFleet.cpp
+ *
+ * Group of PI3EQX12908 redrivers configured and checked together.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "RedriverFleet.h"
+#include <string.h>
+
+/**************************************************************************/
+/*!
+    @brief  Creates an empty fleet
+*/
+/**************************************************************************/
+RedriverFleet::RedriverFleet() : _count(0){
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds a redriver to the fleet
+    @param  device
+            An initialized redriver. It must outlive the fleet.
+    @return false if the fleet is full.
+*/
+/**************************************************************************/
+bool RedriverFleet::add(PI3EQX12908& device){
+  if(_count >= FLEET_MAX_DEVICES)
+    return false;
+  _devices[_count++] = &device;
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Applies one configuration to every redriver
+            The register image is built once and then streamed to each
+            redriver with one burst write per chip.
+    @param  desired
+            The configuration to apply. Read only fields are ignored.
+    @return Bit mask of the redrivers whose write failed (bit i for the
+            i-th added redriver).
+*/
+/**************************************************************************/
+uint16_t RedriverFleet::apply(const RedriverState& desired){
+  uint8_t data[REG_COUNT];
+  desired.encode(data);
+  return applyImage(&data[SHADOW_FIRST_REG]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes one register image to every redriver
+    @param  image
+            #SHADOW_LEN bytes for #POWER_DOWN_REG to #SIGNAL_DET_TH_REG.
+    @return Bit mask of the redrivers whose write failed, see apply().
+*/
+/**************************************************************************/
+uint16_t RedriverFleet::applyImage(const uint8_t* image){
+  uint16_t failed = 0;
+  for(uint8_t i=0; i<_count; i++)
+    if(_devices[i]->writeImage(image) != BUS_OK)
+      failed |= 1 << i;
+  return failed;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Takes a snapshot of every redriver
+    @param  states
+            A pointer to an array of size() states, in the order the
+            redrivers were added.
+*/
+/**************************************************************************/
+void RedriverFleet::snapshot(RedriverState* states){
+  for(uint8_t i=0; i<_count; i++)
+    _devices[i]->snapshot(states[i]);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compares every redriver with an expected configuration
+            Only the writable registers are compared. They are read from
+            the chips, past the shadow cache, so drift behind the driver
+            is found on cached redrivers too.
+    @param  expected
+            The expected configuration.
+    @return Bit mask of the redrivers that differ or could not be read
+            (bit i for the i-th added redriver).
+*/
+/**************************************************************************/
+uint16_t RedriverFleet::compare(const RedriverState& expected){
+  uint8_t data[REG_COUNT];
+  uint8_t image[SHADOW_LEN];
+  uint16_t differ = 0;
+  expected.encode(data);
+  for(uint8_t i=0; i<_count; i++){
+    if(_devices[i]->_bus_read(SHADOW_FIRST_REG, image, SHADOW_LEN) != BUS_OK || memcmp(image, &data[SHADOW_FIRST_REG], SHADOW_LEN))
+      differ |= 1 << i;
+  }
+  return differ;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds the redrivers that disagree with the fleet majority
+            Every redriver is read once, past the shadow cache; for each
+            writable register the value held by most redrivers is taken
+            as the reference. Redrivers that cannot be read do not vote.
+    @return Bit mask of the redrivers with at least one register that
+            differs from the majority, or that could not be read (bit i
+            for the i-th added redriver).
+*/
+/**************************************************************************/
+uint16_t RedriverFleet::findOutliers(){
+  uint8_t images[FLEET_MAX_DEVICES][SHADOW_LEN];
+  uint16_t failed = 0;
+  uint16_t outliers = 0;
+  for(uint8_t i=0; i<_count; i++)
+    if(_devices[i]->_bus_read(SHADOW_FIRST_REG, images[i], SHADOW_LEN) != BUS_OK)
+      failed |= 1 << i;
+
+  for(uint8_t reg=0; reg<SHADOW_LEN; reg++){
+    uint8_t majority = 0;
+    uint8_t best = 0;
+    for(uint8_t i=0; i<_count; i++){
+      if(failed & (1 << i))
+        continue;
+      uint8_t votes = 0;
+      for(uint8_t j=0; j<_count; j++)
+        if(!(failed & (1 << j)) && images[j][reg] == images[i][reg])
+          votes++;
+      if(votes > best){
+        best = votes;
+        majority = images[i][reg];
+      }
+    }
+    for(uint8_t i=0; i<_count; i++)
+      if(!(failed & (1 << i)) && images[i][reg] != majority)
+        outliers |= 1 << i;
+  }
+  return outliers | failed;
+}
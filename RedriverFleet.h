@@ -0,0 +1,48 @@
+/*!
+ * @file RedriverFleet.h
+ *
+ * Group of PI3EQX12908 redrivers (on one or several buses) that are
+ * configured and checked together.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_FLEET_H
+#define _REDRIVER_FLEET_H
+
+#include "PI3EQX12908A2.h"
+
+#ifndef FLEET_MAX_DEVICES
+#define FLEET_MAX_DEVICES 8 ///< Maximum number of redrivers in a fleet
+#endif
+
+/**************************************************************************/
+/*! 
+    @brief  Class that applies, snapshots and compares a set of redrivers
+            Each redriver is a PI3EQX12908 already initialized with its
+            address and transport.
+*/
+/**************************************************************************/
+class RedriverFleet{
+  public:
+    RedriverFleet();
+
+    bool add(PI3EQX12908& device);
+    uint8_t size() const { return _count; }
+    PI3EQX12908& operator[](uint8_t index) { return *_devices[index]; }
+
+    uint16_t apply(const RedriverState& desired);
+    uint16_t applyImage(const uint8_t* image);
+    void snapshot(RedriverState* states);
+    uint16_t compare(const RedriverState& expected);
+    uint16_t findOutliers();
+
+  private:
+    PI3EQX12908* _devices[FLEET_MAX_DEVICES];
+    uint8_t      _count;
+};
+
+#endif
@@ -0,0 +1,322 @@
+/*!
+ * @file RedriverFormat.cpp
+ *
+ * Text rendering of PI3EQX12908 register dumps.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "RedriverFormat.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*! 
+    @brief  Output of the formatter
+            Collects characters into a caller buffer (truncating, always
+            zero terminated) or into a chunk that is written to a Print
+            whenever it fills up. The total length is counted either way.
+*/
+/**************************************************************************/
+class FormatSink{
+  public:
+    FormatSink(char* buf, size_t size) : _out(NULL), _buf(buf), _size(size), _len(0), _total(0) {}
+    FormatSink(Print& out, char* chunk, size_t size) : _out(&out), _buf(chunk), _size(size), _len(0), _total(0) {}
+
+    void put(char c){
+      _total++;
+      if(_out){
+        _buf[_len++] = c;
+        if(_len == _size)
+          _flush();
+      }else if(_len + 1 < _size){
+        _buf[_len++] = c;
+      }
+    }
+
+    void str_P(const char* str){
+      char c;
+      while((c = pgm_read_byte(str++)))
+        put(c);
+    }
+
+    void num(int32_t value){
+      char digits[11];
+      uint8_t n = 0;
+      uint32_t v = value < 0 ? -(uint32_t)value : value;
+      if(value < 0)
+        put('-');
+      do{
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+      }while(v);
+      while(n)
+        put(digits[--n]);
+    }
+
+    void hex(uint8_t value){
+      static const char DIGITS[] = "0123456789ABCDEF";
+      put(DIGITS[value >> 4]);
+      put(DIGITS[value & 0x0F]);
+    }
+
+    size_t finish(){
+      if(_out)
+        _flush();
+      else if(_size)
+        _buf[_len] = 0;
+      return _total;
+    }
+
+  private:
+    Print* _out;
+    char*  _buf;
+    size_t _size;
+    size_t _len;
+    size_t _total;
+
+    void _flush(){
+      if(_len)
+        _out->write((const uint8_t*)_buf, _len);
+      _len = 0;
+    }
+};
+
+static void _lane_name(FormatSink& sink, uint8_t channel){
+  sink.put(channel < 4 ? 'A' : 'B');
+  sink.put('0' + (channel & 3));
+}
+
+static uint8_t _lane_bit(uint8_t channel){
+  return channel < 4 ? 1 << (channel + 4) : 1 << (channel - 4);
+}
+
+static int8_t _gain_db(uint8_t flat_gain){
+  return 2 * flat_gain - 4;
+}
+
+static uint16_t _swing_mvpp(uint8_t swing){
+  return swing ? 1000 : 900;
+}
+
+static uint8_t _sdt_off_mvpp(uint8_t sdt){
+  static const uint8_t OFF[4] = {30, 50, 70, 110};
+  return OFF[sdt & 3];
+}
+
+static void _raw(FormatSink& sink, const uint8_t* data, uint8_t len){
+  for(uint8_t i=0; i<len; i++){
+    sink.str_P(PI3EQX12908::regName(i));
+    sink.str_P(PSTR(" = BIN: "));
+    for(int8_t b=7; b>=0; b--)
+      sink.put('0' + ((data[i] >> b) & 1));
+    sink.str_P(PSTR(" - HEX: 0x"));
+    sink.hex(data[i]);
+    sink.str_P(PSTR("\r\n"));
+  }
+}
+
+static void _decoded(FormatSink& sink, const RedriverState& state){
+  sink.str_P(PSTR("LANE SD RX PD SDPD RXPD EQ   GAIN  SWING\r\n"));
+  for(uint8_t ch=0; ch<8; ch++){
+    uint8_t bit = _lane_bit(ch);
+    sink.put(' ');
+    _lane_name(sink, ch);
+    sink.str_P(PSTR("   "));
+    sink.put(state.signal_detect & bit ? '1' : '0');
+    sink.str_P(PSTR("  "));
+    sink.put(state.rx_detect & bit ? '1' : '0');
+    sink.str_P(PSTR("  "));
+    sink.put(state.power_down & bit ? '1' : '0');
+    sink.str_P(PSTR("    "));
+    sink.put(state.sd_config & bit ? '1' : '0');
+    sink.str_P(PSTR("    "));
+    sink.put(state.rx_config & bit ? '1' : '0');
+    sink.str_P(state.eq[ch] < 10 ? PSTR("  ") : PSTR(" "));
+    sink.num(state.eq[ch]);
+    int8_t db = _gain_db(state.flat_gain[ch]);
+    sink.str_P(db ? PSTR("   ") : PSTR("    "));
+    if(db > 0)
+      sink.put('+');
+    sink.num(db);
+    sink.str_P(PSTR("dB "));
+    sink.num(_swing_mvpp(state.swing[ch]));
+    sink.str_P(PSTR("mVpp\r\n"));
+  }
+  sink.str_P(PSTR("SDT: off "));
+  sink.num(_sdt_off_mvpp(state.sdt));
+  sink.str_P(PSTR(" mVpp, on "));
+  sink.num(_sdt_off_mvpp(state.sdt) + 100);
+  sink.str_P(PSTR(" mVpp\r\n"));
+}
+
+static void _csv(FormatSink& sink, const RedriverState& state){
+  sink.str_P(PSTR("lane,signal_detect,rx_detect,power_down,sd_power_down,rx_power_down,eq,gain_db,swing_mvpp,sdt_off_mvpp,sdt_on_mvpp\r\n"));
+  for(uint8_t ch=0; ch<8; ch++){
+    uint8_t bit = _lane_bit(ch);
+    _lane_name(sink, ch);
+    sink.put(',');
+    sink.put(state.signal_detect & bit ? '1' : '0');
+    sink.put(',');
+    sink.put(state.rx_detect & bit ? '1' : '0');
+    sink.put(',');
+    sink.put(state.power_down & bit ? '1' : '0');
+    sink.put(',');
+    sink.put(state.sd_config & bit ? '1' : '0');
+    sink.put(',');
+    sink.put(state.rx_config & bit ? '1' : '0');
+    sink.put(',');
+    sink.num(state.eq[ch]);
+    sink.put(',');
+    sink.num(_gain_db(state.flat_gain[ch]));
+    sink.put(',');
+    sink.num(_swing_mvpp(state.swing[ch]));
+    sink.put(',');
+    sink.num(_sdt_off_mvpp(state.sdt));
+    sink.put(',');
+    sink.num(_sdt_off_mvpp(state.sdt) + 100);
+    sink.str_P(PSTR("\r\n"));
+  }
+}
+
+static void _json(FormatSink& sink, const RedriverState& state){
+  sink.str_P(PSTR("{\"regs\":["));
+  for(uint8_t i=0; i<REG_COUNT; i++){
+    if(i)
+      sink.put(',');
+    sink.num(state.regs[i]);
+  }
+  sink.str_P(PSTR("],\"sdt\":{\"off_mvpp\":"));
+  sink.num(_sdt_off_mvpp(state.sdt));
+  sink.str_P(PSTR(",\"on_mvpp\":"));
+  sink.num(_sdt_off_mvpp(state.sdt) + 100);
+  sink.str_P(PSTR("},\"lanes\":["));
+  for(uint8_t ch=0; ch<8; ch++){
+    uint8_t bit = _lane_bit(ch);
+    sink.str_P(ch ? PSTR(",{\"lane\":\"") : PSTR("{\"lane\":\""));
+    _lane_name(sink, ch);
+    sink.str_P(PSTR("\",\"signal_detect\":"));
+    sink.put(state.signal_detect & bit ? '1' : '0');
+    sink.str_P(PSTR(",\"rx_detect\":"));
+    sink.put(state.rx_detect & bit ? '1' : '0');
+    sink.str_P(PSTR(",\"power_down\":"));
+    sink.put(state.power_down & bit ? '1' : '0');
+    sink.str_P(PSTR(",\"sd_power_down\":"));
+    sink.put(state.sd_config & bit ? '1' : '0');
+    sink.str_P(PSTR(",\"rx_power_down\":"));
+    sink.put(state.rx_config & bit ? '1' : '0');
+    sink.str_P(PSTR(",\"eq\":"));
+    sink.num(state.eq[ch]);
+    sink.str_P(PSTR(",\"gain_db\":"));
+    sink.num(_gain_db(state.flat_gain[ch]));
+    sink.str_P(PSTR(",\"swing_mvpp\":"));
+    sink.num(_swing_mvpp(state.swing[ch]));
+    sink.put('}');
+  }
+  sink.str_P(PSTR("]}\r\n"));
+}
+
+static size_t _format(FormatSink& sink, const uint8_t* data, uint8_t len, uint8_t format){
+  if(format == FORMAT_RAW){
+    _raw(sink, data, len);
+  }else if(len >= REG_COUNT){
+    RedriverState state;
+    state.decode(data);
+    if(format == FORMAT_DECODED)
+      _decoded(sink, state);
+    else if(format == FORMAT_CSV)
+      _csv(sink, state);
+    else if(format == FORMAT_JSON)
+      _json(sink, state);
+  }
+  return sink.finish();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Renders a register dump into a buffer
+            Like snprintf(), the output is truncated to size - 1
+            characters and zero terminated; pass size 0 to measure.
+    @param  data
+            Registers starting at register 0.
+    @param  len
+            Number of registers; the decoded formats need at least
+            #REG_COUNT.
+    @param  format
+            #FORMAT_RAW, #FORMAT_DECODED, #FORMAT_CSV or #FORMAT_JSON.
+    @param  buf
+            Output buffer.
+    @param  size
+            Size of the output buffer.
+    @return Length of the complete output, without the terminator.
+*/
+/**************************************************************************/
+size_t formatRegisters(const uint8_t* data, uint8_t len, uint8_t format, char* buf, size_t size){
+  FormatSink sink(buf, size);
+  return _format(sink, data, len, format);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prints a register dump
+            The text is collected in a #FORMAT_CHUNK byte buffer on the
+            stack and written in chunks, not character by character.
+    @param  out
+            Destination, for example Serial.
+    @param  data
+            Registers starting at register 0.
+    @param  len
+            Number of registers; the decoded formats need at least
+            #REG_COUNT.
+    @param  format
+            #FORMAT_RAW, #FORMAT_DECODED, #FORMAT_CSV or #FORMAT_JSON.
+    @return Number of characters written.
+*/
+/**************************************************************************/
+size_t printRegisters(Print& out, const uint8_t* data, uint8_t len, uint8_t format){
+  char chunk[FORMAT_CHUNK];
+  FormatSink sink(out, chunk, FORMAT_CHUNK);
+  return _format(sink, data, len, format);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Renders a snapshot into a buffer, see formatRegisters()
+            The fields are encoded first, so changes made to them since
+            the snapshot are shown.
+*/
+/**************************************************************************/
+size_t formatState(const RedriverState& state, uint8_t format, char* buf, size_t size){
+  uint8_t data[REG_COUNT];
+  state.encode(data);
+  return formatRegisters(data, REG_COUNT, format, buf, size);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prints a snapshot, see printRegisters()
+            The fields are encoded first, as in formatState().
+*/
+/**************************************************************************/
+size_t printState(Print& out, const RedriverState& state, uint8_t format){
+  uint8_t data[REG_COUNT];
+  state.encode(data);
+  return printRegisters(out, data, REG_COUNT, format);
+}
+
+#ifndef ARDUINO
+/**************************************************************************/
+/*!
+    @brief  Renders a snapshot into a string (host builds only)
+*/
+/**************************************************************************/
+std::string formatState(const RedriverState& state, uint8_t format){
+  size_t len = formatState(state, format, NULL, 0);
+  std::string text(len + 1, '\0');
+  formatState(state, format, &text[0], len + 1);
+  text.resize(len);
+  return text;
+}
+#endif
@@ -0,0 +1,41 @@
+/*!
+ * @file RedriverFormat.h
+ *
+ * Text rendering of PI3EQX12908 register dumps: raw, decoded, CSV and
+ * JSON, to any Print, a caller buffer or (on a host) a std::string.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_FORMAT_H
+#define _REDRIVER_FORMAT_H
+
+#include "PI3EQX12908A2.h"
+
+#ifndef ARDUINO
+#include <string>
+#endif
+
+#define FORMAT_RAW      0 ///< One line per register in binary and hex, as print_all()
+#define FORMAT_DECODED  1 ///< One line per lane: flags, EQ index, gain in dB, swing in mVpp
+#define FORMAT_CSV      2 ///< Header and one row per lane
+#define FORMAT_JSON     3 ///< One JSON object with the registers and the decoded lanes
+
+#ifndef FORMAT_CHUNK
+#define FORMAT_CHUNK    64 ///< Bytes collected before each write to a Print
+#endif
+
+class Print;
+
+size_t formatRegisters(const uint8_t* data, uint8_t len, uint8_t format, char* buf, size_t size);
+size_t printRegisters(Print& out, const uint8_t* data, uint8_t len, uint8_t format);
+size_t formatState(const RedriverState& state, uint8_t format, char* buf, size_t size);
+size_t printState(Print& out, const RedriverState& state, uint8_t format);
+#ifndef ARDUINO
+std::string formatState(const RedriverState& state, uint8_t format);
+#endif
+
+#endif
@@ -0,0 +1,293 @@
+/*!
+ * @file RedriverInstrument.cpp
+ *
+ * Optional instrumentation of the PI3EQX12908 driver.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "RedriverInstrument.h"
+
+#ifdef PI3EQX12908_INSTRUMENT
+
+#include "PI3EQX12908A2.h"
+#include "Arduino.h"
+
+InstrumentCounters RedriverInstrument::_counters;
+uint32_t           RedriverInstrument::_bus_hist[INSTRUMENT_HIST_BINS];
+uint32_t           RedriverInstrument::_api_hist[INSTRUMENT_HIST_BINS];
+TraceEntry         RedriverInstrument::_trace[INSTRUMENT_TRACE_LEN];
+volatile uint8_t   RedriverInstrument::_trace_head;
+volatile uint8_t   RedriverInstrument::_trace_fill;
+ApiStats*          RedriverInstrument::_api_first;
+ApiStats*          RedriverInstrument::_api_last;
+uint16_t           RedriverInstrument::_api_count;
+
+// Keeps the compiler from moving memory accesses across it, so a trace
+// entry is copied between the two reads of the head and published only
+// once it is complete
+static inline void _barrier(){
+  __asm__ __volatile__("" ::: "memory");
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears every statistic and the trace
+            APIs stay in the list, only their numbers are cleared.
+*/
+/**************************************************************************/
+void RedriverInstrument::reset(){
+  memset(&_counters, 0, sizeof(_counters));
+  memset(_bus_hist, 0, sizeof(_bus_hist));
+  memset(_api_hist, 0, sizeof(_api_hist));
+  _trace_fill = 0;
+  for(ApiStats* stats = _api_first; stats; stats = stats->next){
+    stats->calls    = 0;
+    stats->total_us = 0;
+    stats->max_us   = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Histogram bin of a duration
+    @param  us
+            Duration in microseconds.
+    @return 0 for 0 us, else the bit length of us, at most
+            #INSTRUMENT_HIST_BINS - 1.
+*/
+/**************************************************************************/
+uint8_t RedriverInstrument::binOf(uint32_t us){
+  uint8_t bin = 0;
+  while(us && bin < INSTRUMENT_HIST_BINS - 1){
+    us >>= 1;
+    bin++;
+  }
+  return bin;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of bus accesses in one bin of the latency histogram
+            A bus access is timed from the first attempt to the end of
+            the last retry.
+    @param  bin
+            0 to #INSTRUMENT_HIST_BINS - 1.
+    @return The count, 0 for a bin out of range.
+*/
+/**************************************************************************/
+uint32_t RedriverInstrument::busHistogram(uint8_t bin){
+  return bin < INSTRUMENT_HIST_BINS ? _bus_hist[bin] : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of public API calls in one bin of the latency histogram
+    @param  bin
+            0 to #INSTRUMENT_HIST_BINS - 1.
+    @return The count, 0 for a bin out of range.
+*/
+/**************************************************************************/
+uint32_t RedriverInstrument::apiHistogram(uint8_t bin){
+  return bin < INSTRUMENT_HIST_BINS ? _api_hist[bin] : 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Number of entries in the trace
+    @return Up to #INSTRUMENT_TRACE_LEN - 1, the slot after the latest
+            entry is the one the next access is written to.
+*/
+/**************************************************************************/
+uint8_t RedriverInstrument::traceCount(){
+  return _trace_fill;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Copies one entry of the trace
+            Safe to call while the driver is adding entries (from an
+            interrupt or the other way round): an entry that was
+            overwritten during the copy is reported as missing.
+    @param  age
+            0 for the latest bus access, 1 for the one before, ...
+    @param  entry
+            Receives the entry.
+    @return false if the trace does not go back that far.
+*/
+/**************************************************************************/
+bool RedriverInstrument::trace(uint8_t age, TraceEntry& entry){
+  uint8_t head = _trace_head;
+  if(age >= _trace_fill)
+    return false;
+  _barrier();
+  entry = _trace[(uint8_t)(head - 1 - age) & (INSTRUMENT_TRACE_LEN - 1)];
+  _barrier();
+  // The entry was overwritten, or is being overwritten, if the head moved too far
+  return (uint8_t)(_trace_head - head) < INSTRUMENT_TRACE_LEN - 1 - age;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Statistics of one public API
+    @param  index
+            0 to apiCount() - 1, in order of the first call.
+    @return A pointer to the statistics or NULL.
+*/
+/**************************************************************************/
+const ApiStats* RedriverInstrument::api(uint16_t index){
+  ApiStats* stats = _api_first;
+  while(stats && index--)
+    stats = stats->next;
+  return stats;
+}
+
+/**************************************************************************/
+/*!
+    @brief  The API with the largest total time
+    @return A pointer to its statistics or NULL if nothing was called.
+*/
+/**************************************************************************/
+const ApiStats* RedriverInstrument::slowest(){
+  const ApiStats* worst = NULL;
+  for(const ApiStats* stats = _api_first; stats; stats = stats->next)
+    if(stats->calls && (!worst || stats->total_us > worst->total_us))
+      worst = stats;
+  return worst;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Prints the counters, both histograms and the API table
+    @param  out
+            Where to print, e.g. Serial.
+*/
+/**************************************************************************/
+void RedriverInstrument::print(Print& out){
+  out.print(F("bus: "));
+  out.print((unsigned long)_counters.bus_reads);
+  out.print(F(" reads "));
+  out.print((unsigned long)_counters.bytes_read);
+  out.print(F(" B, "));
+  out.print((unsigned long)_counters.bus_writes);
+  out.print(F(" writes "));
+  out.print((unsigned long)_counters.bytes_written);
+  out.print(F(" B, "));
+  out.print((unsigned long)_counters.errors);
+  out.println(F(" errors"));
+  out.print(F("registers: "));
+  out.print((unsigned long)_counters.burst_reads);
+  out.print(F(" reads ("));
+  out.print((unsigned long)_counters.cache_hits);
+  out.print(F(" cached), "));
+  out.print((unsigned long)_counters.burst_writes);
+  out.print(F(" writes ("));
+  out.print((unsigned long)_counters.buffered);
+  out.println(F(" buffered)"));
+  out.println(F("us\tbus\tapi"));
+  for(uint8_t bin=0; bin<INSTRUMENT_HIST_BINS; bin++){
+    if(!_bus_hist[bin] && !_api_hist[bin])
+      continue;
+    if(bin == INSTRUMENT_HIST_BINS - 1){
+      out.print(F(">="));
+      out.print((unsigned long)1 << (bin - 1));
+    }else{
+      out.print(F("<"));
+      out.print((unsigned long)1 << bin);
+    }
+    out.print(F("\t"));
+    out.print((unsigned long)_bus_hist[bin]);
+    out.print(F("\t"));
+    out.println((unsigned long)_api_hist[bin]);
+  }
+  out.println(F("calls\ttotal_us\tmax_us\tapi"));
+  for(const ApiStats* stats = _api_first; stats; stats = stats->next){
+    if(!stats->calls)
+      continue;
+    out.print((unsigned long)stats->calls);
+    out.print(F("\t"));
+    out.print((unsigned long)stats->total_us);
+    out.print(F("\t"));
+    out.print((unsigned long)stats->max_us);
+    out.print(F("\t"));
+    out.println((const __FlashStringHelper*)stats->name);
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Records one bus access
+    @private
+*/
+/**************************************************************************/
+void RedriverInstrument::bus(uint8_t addr, uint8_t op, uint8_t reg, uint8_t len, uint8_t status, uint32_t start){
+  if(op == TRACE_READ){
+    _counters.bus_reads++;
+    _counters.bytes_read += reg + len;
+  }else{
+    _counters.bus_writes++;
+    _counters.bytes_written += len + 1;
+  }
+  if(status != BUS_OK)
+    _counters.errors++;
+  _bus_hist[binOf(micros() - start)]++;
+
+  uint8_t head = _trace_head;
+  TraceEntry& entry = _trace[head & (INSTRUMENT_TRACE_LEN - 1)];
+  entry.time_us = start;
+  entry.addr    = addr;
+  entry.op      = op;
+  entry.reg     = reg;
+  entry.len     = len;
+  entry.status  = status;
+  // Publish the entry only once it is complete
+  _barrier();
+  _trace_head = head + 1;
+  if(_trace_fill < INSTRUMENT_TRACE_LEN - 1)
+    _trace_fill = _trace_fill + 1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Adds an API to the list on its first call
+    @private
+*/
+/**************************************************************************/
+void RedriverInstrument::apiStart(ApiStats& stats){
+  if(stats.next || &stats == _api_last)
+    return;
+  if(_api_last)
+    _api_last->next = &stats;
+  else
+    _api_first = &stats;
+  _api_last = &stats;
+  _api_count++;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Records one public API call
+    @private
+*/
+/**************************************************************************/
+void RedriverInstrument::apiDone(ApiStats& stats, uint32_t elapsed){
+  _api_hist[binOf(elapsed)]++;
+  stats.calls++;
+  stats.total_us += elapsed;
+  if(elapsed > stats.max_us)
+    stats.max_us = elapsed;
+}
+
+InstrumentScope::InstrumentScope(ApiStats& stats) : _stats(stats){
+  RedriverInstrument::apiStart(stats);
+  _start = micros();
+}
+
+InstrumentScope::~InstrumentScope(){
+  RedriverInstrument::apiDone(_stats, micros() - _start);
+}
+
+#endif
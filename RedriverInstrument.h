@@ -0,0 +1,172 @@
+/*!
+ * @file RedriverInstrument.h
+ *
+ * Optional instrumentation of the PI3EQX12908 driver: bus and cache
+ * counters, log2 latency histograms, per-API call statistics and a trace
+ * of the last bus transactions.
+ *
+ * Everything here is compiled only when the whole build defines
+ * PI3EQX12908_INSTRUMENT (for example -DPI3EQX12908_INSTRUMENT in the
+ * build flags); otherwise the hooks in the driver expand to nothing and
+ * RedriverInstrument does not exist.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_INSTRUMENT_H
+#define _REDRIVER_INSTRUMENT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define TRACE_READ   0 ///< Trace entry of a bus read
+#define TRACE_WRITE  1 ///< Trace entry of a bus write
+
+#ifdef PI3EQX12908_INSTRUMENT
+
+#ifndef INSTRUMENT_TRACE_LEN
+#define INSTRUMENT_TRACE_LEN  32 ///< Trace slots, a power of 2 up to 128; the trace holds one access less
+#endif
+
+#define INSTRUMENT_HIST_BINS  16 ///< Bin 0 counts 0 us, bin n counts 2^(n-1) to 2^n - 1 us, the last bin is open ended
+
+#if (INSTRUMENT_TRACE_LEN & (INSTRUMENT_TRACE_LEN - 1)) || INSTRUMENT_TRACE_LEN > 128
+#error "INSTRUMENT_TRACE_LEN must be a power of 2 up to 128"
+#endif
+
+class Print;
+
+/**************************************************************************/
+/*!
+    @brief  Totals since the last RedriverInstrument::reset()
+            burst_reads and burst_writes count register accesses made by
+            the driver, bus_reads and bus_writes the I2C transactions they
+            turned into. The rest were served from the prefetch or the
+            shadow (cache_hits) or collected by a transaction (buffered).
+*/
+/**************************************************************************/
+struct InstrumentCounters{
+  uint32_t burst_reads;   ///< Register reads asked for
+  uint32_t burst_writes;  ///< Register writes asked for
+  uint32_t cache_hits;    ///< Reads answered without a bus access
+  uint32_t buffered;      ///< Writes held back by a transaction
+  uint32_t bus_reads;     ///< I2C reads, a retried one counts once
+  uint32_t bus_writes;    ///< I2C writes, a retried one counts once
+  uint32_t bytes_read;    ///< Bytes read on the wire, the register 0 prefix included
+  uint32_t bytes_written; ///< Bytes written on the wire, the address byte included
+  uint32_t errors;        ///< Bus accesses that failed after all retries
+};
+
+/**************************************************************************/
+/*!
+    @brief  One bus access in the trace
+*/
+/**************************************************************************/
+struct TraceEntry{
+  uint32_t time_us; ///< micros() when the access started
+  uint8_t  addr;    ///< 7 bit I2C address of the redriver
+  uint8_t  op;      ///< #TRACE_READ or #TRACE_WRITE
+  uint8_t  reg;     ///< First register
+  uint8_t  len;     ///< Number of registers
+  uint8_t  status;  ///< BUS_* status after the retries
+};
+
+/**************************************************************************/
+/*!
+    @brief  Call statistics of one public API
+            Every instrumented function owns one, so there is no limit on
+            the number of APIs; overloads are told apart by their name.
+            Times are inclusive: an API that calls another one also
+            counts the time spent in it.
+*/
+/**************************************************************************/
+struct ApiStats{
+  const char* name;     ///< Function name, in PROGMEM
+  uint32_t    calls;    ///< Number of calls
+  uint32_t    total_us; ///< Time spent in the calls
+  uint32_t    max_us;   ///< Longest call
+  ApiStats*   next;     ///< Next API in order of the first call, @private
+};
+
+/**************************************************************************/
+/*!
+    @brief  Queries and hooks of the instrumentation
+            There is one set of statistics for all PI3EQX12908 objects.
+            The driver is the only writer; the trace can be read at any
+            time, the other statistics from the same context as the
+            driver.
+*/
+/**************************************************************************/
+class RedriverInstrument{
+  public:
+    static void reset();
+    static const InstrumentCounters& counters() { return _counters; } ///< Bus and cache counters
+    static uint32_t busHistogram(uint8_t bin);
+    static uint32_t apiHistogram(uint8_t bin);
+    static uint8_t traceCount();
+    static bool trace(uint8_t age, TraceEntry& entry);
+    static uint16_t apiCount() { return _api_count; } ///< Number of APIs called so far
+    static const ApiStats* api(uint16_t index);
+    static const ApiStats* slowest();
+    static void print(Print& out);
+
+    static uint8_t binOf(uint32_t us);
+
+    // Hooks used by the driver
+    static void burst(uint8_t op) { if(op == TRACE_READ) _counters.burst_reads++; else _counters.burst_writes++; } ///< @private
+    static void cacheHit() { _counters.cache_hits++; } ///< @private
+    static void buffered() { _counters.buffered++; }   ///< @private
+    static void bus(uint8_t addr, uint8_t op, uint8_t reg, uint8_t len, uint8_t status, uint32_t start);
+    static void apiStart(ApiStats& stats);
+    static void apiDone(ApiStats& stats, uint32_t elapsed);
+
+  private:
+    static InstrumentCounters _counters;
+    static uint32_t           _bus_hist[INSTRUMENT_HIST_BINS];
+    static uint32_t           _api_hist[INSTRUMENT_HIST_BINS];
+    static TraceEntry         _trace[INSTRUMENT_TRACE_LEN];
+    static volatile uint8_t   _trace_head;
+    static volatile uint8_t   _trace_fill;
+    static ApiStats*          _api_first;
+    static ApiStats*          _api_last;
+    static uint16_t           _api_count;
+};
+
+/**************************************************************************/
+/*!
+    @brief  Times one public API call from construction to destruction
+*/
+/**************************************************************************/
+class InstrumentScope{
+  public:
+    InstrumentScope(ApiStats& stats);
+    ~InstrumentScope();
+
+  private:
+    ApiStats& _stats;
+    uint32_t  _start;
+};
+
+#define INSTRUMENT_API(name) \
+  static const char _instrument_name[] PROGMEM = name; \
+  static ApiStats _instrument_stats = {_instrument_name, 0, 0, 0, NULL}; \
+  InstrumentScope _instrument_scope(_instrument_stats)
+#define INSTRUMENT_BURST(op)                          RedriverInstrument::burst(op)
+#define INSTRUMENT_CACHE_HIT()                        RedriverInstrument::cacheHit()
+#define INSTRUMENT_BUFFERED()                         RedriverInstrument::buffered()
+#define INSTRUMENT_BUS(addr, op, reg, len, status, start) RedriverInstrument::bus(addr, op, reg, len, status, start)
+
+#else
+
+#define INSTRUMENT_API(name)
+#define INSTRUMENT_BURST(op)
+#define INSTRUMENT_CACHE_HIT()
+#define INSTRUMENT_BUFFERED()
+#define INSTRUMENT_BUS(addr, op, reg, len, status, start)
+
+#endif
+
+#endif
@@ -0,0 +1,250 @@
+/*!
+ * @file RedriverProfile.cpp
+ *
+ * Versioned, CRC-protected configuration profiles for the PI3EQX12908.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "RedriverProfile.h"
+#include "RedriverCrc.h"
+#include "Arduino.h"
+
+#define PROFILE_NAME_OFFSET   4
+#define PROFILE_IMAGE_OFFSET  (PROFILE_NAME_OFFSET + PROFILE_NAME_LEN)
+#define PROFILE_CRC_OFFSET    (PROFILE_IMAGE_OFFSET + SHADOW_LEN)
+
+/**************************************************************************/
+/*!
+    @brief  Sets the name of the profile
+    @param  text
+            Zero terminated name, truncated to #PROFILE_NAME_LEN
+            characters.
+*/
+/**************************************************************************/
+void RedriverProfile::setName(const char* text){
+  uint8_t i = 0;
+  for(; i<PROFILE_NAME_LEN && text[i]; i++)
+    name[i] = text[i];
+  for(; i<=PROFILE_NAME_LEN; i++)
+    name[i] = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Compares the name of the profile
+    @param  text
+            Zero terminated name, compared on its first
+            #PROFILE_NAME_LEN characters.
+    @return true if the names match.
+*/
+/**************************************************************************/
+bool RedriverProfile::hasName(const char* text) const{
+  for(uint8_t i=0; i<PROFILE_NAME_LEN; i++){
+    if(name[i] != text[i])
+      return false;
+    if(!text[i])
+      return true;
+  }
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Serializes the profile
+    @param  data
+            A pointer to an array of #PROFILE_SIZE bytes.
+*/
+/**************************************************************************/
+void RedriverProfile::toBytes(uint8_t* data) const{
+  data[0] = PROFILE_MAGIC;
+  data[1] = PROFILE_VERSION;
+  data[2] = revision & 0xFF;
+  data[3] = revision >> 8;
+  for(uint8_t i=0; i<PROFILE_NAME_LEN; i++)
+    data[PROFILE_NAME_OFFSET + i] = name[i];
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    data[PROFILE_IMAGE_OFFSET + i] = image[i];
+  uint16_t crc = redriverCrc16(data, PROFILE_CRC_OFFSET);
+  data[PROFILE_CRC_OFFSET] = crc & 0xFF;
+  data[PROFILE_CRC_OFFSET + 1] = crc >> 8;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Deserializes a profile
+            The profile is only changed if the data is valid.
+    @param  data
+            A pointer to an array of #PROFILE_SIZE bytes.
+    @return #PROFILE_OK, #PROFILE_ERR_MAGIC, #PROFILE_ERR_VERSION or
+            #PROFILE_ERR_CRC.
+*/
+/**************************************************************************/
+uint8_t RedriverProfile::fromBytes(const uint8_t* data){
+  if(data[0] != PROFILE_MAGIC)
+    return PROFILE_ERR_MAGIC;
+  if(data[1] != PROFILE_VERSION)
+    return PROFILE_ERR_VERSION;
+  uint16_t crc = data[PROFILE_CRC_OFFSET] | (data[PROFILE_CRC_OFFSET + 1] << 8);
+  if(redriverCrc16(data, PROFILE_CRC_OFFSET) != crc)
+    return PROFILE_ERR_CRC;
+  revision = data[2] | (data[3] << 8);
+  for(uint8_t i=0; i<PROFILE_NAME_LEN; i++)
+    name[i] = data[PROFILE_NAME_OFFSET + i];
+  name[PROFILE_NAME_LEN] = 0;
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    image[i] = data[PROFILE_IMAGE_OFFSET + i];
+  return PROFILE_OK;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Storage backend on a RAM buffer
+    @param  arg
+            The buffer (uint8_t*).
+*/
+/**************************************************************************/
+bool profileBufferRead(uint16_t addr, uint8_t* data, uint16_t len, void* arg){
+  memcpy(data, (const uint8_t*)arg + addr, len);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Storage backend on a RAM buffer
+    @param  arg
+            The buffer (uint8_t*).
+*/
+/**************************************************************************/
+bool profileBufferWrite(uint16_t addr, const uint8_t* data, uint16_t len, void* arg){
+  memcpy((uint8_t*)arg + addr, data, len);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Read-only storage backend on a PROGMEM array
+    @param  arg
+            The array (const uint8_t* in PROGMEM).
+*/
+/**************************************************************************/
+bool profileProgmemRead(uint16_t addr, uint8_t* data, uint16_t len, void* arg){
+  memcpy_P(data, (const uint8_t*)arg + addr, len);
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Creates a profile store
+    @param  read
+            Storage read function.
+    @param  write
+            Storage write function, NULL for read-only storage.
+    @param  arg
+            Passed to read and write.
+    @param  base
+            Storage address of slot 0.
+    @param  slots
+            Number of slots.
+*/
+/**************************************************************************/
+ProfileStore::ProfileStore(ProfileRead read, ProfileWrite write, void* arg, uint16_t base, uint8_t slots)
+  : _read(read), _write(write), _arg(arg), _base(base), _slots(slots){}
+
+/**************************************************************************/
+/*!
+    @brief  Saves a profile to a slot
+    @param  slot
+            Slot number.
+    @param  profile
+            The profile.
+    @return #PROFILE_OK, #PROFILE_ERR_SLOT or #PROFILE_ERR_STORAGE.
+*/
+/**************************************************************************/
+uint8_t ProfileStore::save(uint8_t slot, const RedriverProfile& profile){
+  uint8_t data[PROFILE_SIZE];
+  if(slot >= _slots)
+    return PROFILE_ERR_SLOT;
+  if(!_write)
+    return PROFILE_ERR_STORAGE;
+  profile.toBytes(data);
+  return _write(_base + slot * PROFILE_SIZE, data, PROFILE_SIZE, _arg) ? PROFILE_OK : PROFILE_ERR_STORAGE;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Loads the profile of a slot
+    @param  slot
+            Slot number.
+    @param  profile
+            Receives the profile.
+    @return #PROFILE_OK or an error of RedriverProfile::fromBytes(),
+            #PROFILE_ERR_SLOT or #PROFILE_ERR_STORAGE.
+*/
+/**************************************************************************/
+uint8_t ProfileStore::load(uint8_t slot, RedriverProfile& profile){
+  uint8_t data[PROFILE_SIZE];
+  if(slot >= _slots)
+    return PROFILE_ERR_SLOT;
+  if(!_read(_base + slot * PROFILE_SIZE, data, PROFILE_SIZE, _arg))
+    return PROFILE_ERR_STORAGE;
+  return profile.fromBytes(data);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Loads a profile by name
+    @param  name
+            Profile name.
+    @param  profile
+            Receives the profile.
+    @return #PROFILE_OK or #PROFILE_ERR_NOT_FOUND.
+*/
+/**************************************************************************/
+uint8_t ProfileStore::loadByName(const char* name, RedriverProfile& profile){
+  RedriverProfile candidate;
+  for(uint8_t slot=0; slot<_slots; slot++){
+    if(load(slot, candidate) == PROFILE_OK && candidate.hasName(name)){
+      profile = candidate;
+      return PROFILE_OK;
+    }
+  }
+  return PROFILE_ERR_NOT_FOUND;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Finds the slot of a profile
+    @param  name
+            Profile name.
+    @return Slot number, or -1 if no valid profile has this name.
+*/
+/**************************************************************************/
+int16_t ProfileStore::find(const char* name){
+  RedriverProfile candidate;
+  for(uint8_t slot=0; slot<_slots; slot++)
+    if(load(slot, candidate) == PROFILE_OK && candidate.hasName(name))
+      return slot;
+  return -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Invalidates a slot
+            Only the magic byte is overwritten.
+    @param  slot
+            Slot number.
+    @return #PROFILE_OK, #PROFILE_ERR_SLOT or #PROFILE_ERR_STORAGE.
+*/
+/**************************************************************************/
+uint8_t ProfileStore::erase(uint8_t slot){
+  uint8_t blank = 0xFF;
+  if(slot >= _slots)
+    return PROFILE_ERR_SLOT;
+  if(!_write)
+    return PROFILE_ERR_STORAGE;
+  return _write(_base + slot * PROFILE_SIZE, &blank, 1, _arg) ? PROFILE_OK : PROFILE_ERR_STORAGE;
+}
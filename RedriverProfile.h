@@ -0,0 +1,113 @@
+/*!
+ * @file RedriverProfile.h
+ *
+ * Versioned, CRC-protected configuration profiles for the PI3EQX12908,
+ * stored in a byte buffer, EEPROM or flash.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _REDRIVER_PROFILE_H
+#define _REDRIVER_PROFILE_H
+
+#include "PI3EQX12908A2.h"
+
+#define PROFILE_MAGIC       0x5A  ///< First byte of a stored profile
+#define PROFILE_VERSION     1     ///< Current profile format version
+#define PROFILE_NAME_LEN    8     ///< Maximum profile name length
+#define PROFILE_SIZE        (4 + PROFILE_NAME_LEN + SHADOW_LEN + 2) ///< Bytes of a stored profile
+
+#define PROFILE_OK              0 ///< Success
+#define PROFILE_ERR_MAGIC       1 ///< No profile at this location
+#define PROFILE_ERR_VERSION     2 ///< Profile format not supported
+#define PROFILE_ERR_CRC         3 ///< Profile corrupted
+#define PROFILE_ERR_STORAGE     4 ///< Storage read or write failed
+#define PROFILE_ERR_SLOT        5 ///< Slot out of range
+#define PROFILE_ERR_NOT_FOUND   6 ///< No profile with this name
+
+/**************************************************************************/
+/*! 
+    @brief  Register image of registers 2 to 13 with its metadata
+            Stored layout (#PROFILE_SIZE bytes): magic, format version,
+            revision (2 bytes, little endian), name (#PROFILE_NAME_LEN
+            bytes, zero padded), image (#SHADOW_LEN bytes) and a
+            CRC-16 of everything before it (little endian).
+*/
+/**************************************************************************/
+struct RedriverProfile{
+  uint16_t revision;                  ///< User-defined revision of the profile
+  char     name[PROFILE_NAME_LEN + 1];  ///< Zero terminated name
+  uint8_t  image[SHADOW_LEN];         ///< Registers #POWER_DOWN_REG to #SIGNAL_DET_TH_REG
+
+  void setName(const char* text);
+  bool hasName(const char* text) const;
+  void toBytes(uint8_t* data) const;
+  uint8_t fromBytes(const uint8_t* data);
+};
+
+/*! @brief Storage read: copies len bytes at addr to data, returns false on failure */
+typedef bool (*ProfileRead)(uint16_t addr, uint8_t* data, uint16_t len, void* arg);
+/*! @brief Storage write: copies len bytes from data to addr, returns false on failure */
+typedef bool (*ProfileWrite)(uint16_t addr, const uint8_t* data, uint16_t len, void* arg);
+
+bool profileBufferRead(uint16_t addr, uint8_t* data, uint16_t len, void* arg);
+bool profileBufferWrite(uint16_t addr, const uint8_t* data, uint16_t len, void* arg);
+bool profileProgmemRead(uint16_t addr, uint8_t* data, uint16_t len, void* arg);
+
+#ifdef EEPROM_h
+/*! @brief EEPROM read, available when EEPROM.h is included before this header */
+inline bool profileEepromRead(uint16_t addr, uint8_t* data, uint16_t len, void*){
+  for(uint16_t i=0; i<len; i++)
+    data[i] = EEPROM.read(addr + i);
+  return true;
+}
+
+/*! @brief EEPROM write, available when EEPROM.h is included before this header */
+inline bool profileEepromWrite(uint16_t addr, const uint8_t* data, uint16_t len, void*){
+  for(uint16_t i=0; i<len; i++){
+#if defined(ESP8266) || defined(ESP32)
+    EEPROM.write(addr + i, data[i]);
+#else
+    EEPROM.update(addr + i, data[i]);
+#endif
+  }
+#if defined(ESP8266) || defined(ESP32)
+  return EEPROM.commit();
+#else
+  return true;
+#endif
+}
+#endif
+
+/**************************************************************************/
+/*! 
+    @brief  Class that keeps named profiles in consecutive slots
+            Slot n lives at base + n * #PROFILE_SIZE of the storage.
+            Use profileBufferRead/Write with a RAM buffer as arg,
+            profileProgmemRead with a PROGMEM array as arg (read only),
+            or profileEepromRead/Write.
+*/
+/**************************************************************************/
+class ProfileStore{
+  public:
+    ProfileStore(ProfileRead read, ProfileWrite write, void* arg, uint16_t base, uint8_t slots);
+
+    uint8_t slots() const { return _slots; } ///< Number of slots
+    uint8_t save(uint8_t slot, const RedriverProfile& profile);
+    uint8_t load(uint8_t slot, RedriverProfile& profile);
+    uint8_t loadByName(const char* name, RedriverProfile& profile);
+    int16_t find(const char* name);
+    uint8_t erase(uint8_t slot);
+
+  private:
+    ProfileRead  _read;
+    ProfileWrite _write;
+    void*        _arg;
+    uint16_t     _base;
+    uint8_t      _slots;
+};
+
+#endif
@@ -0,0 +1,192 @@
+/*!
+ * @file SweepEngine.cpp
+ *
+ * EQ / flat gain / swing sweep for PI3EQX12908 channels.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#include "SweepEngine.h"
+#include "Arduino.h"
+
+/**************************************************************************/
+/*!
+    @brief  Creates a sweep engine for a redriver
+    @param  rd
+            An initialized redriver.
+*/
+/**************************************************************************/
+SweepEngine::SweepEngine(PI3EQX12908& rd)
+  : _rd(&rd), _metric(NULL), _arg(NULL), _target(SWEEP_NO_TARGET), _settle(0),
+    _writes(0), _lanes(0), _done(0), _status(BUS_OK){
+  for(uint8_t i=0; i<8; i++){
+    _cfg[i] = 0;
+    _best[i] = 0;
+    _best_metric[i] = 0;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sweeps all 16 x 4 x 2 points
+            When the sweep ends, every lane is left at its best point.
+    @param  lanes
+            Bit mask of the lanes to tune.
+    @param  metric
+            Quality metric, called once per lane and point.
+    @param  arg
+            Passed to the metric.
+    @return Number of points visited, see status() for bus errors.
+*/
+/**************************************************************************/
+uint16_t SweepEngine::run(uint8_t lanes, Metric metric, void* arg){
+  const int8_t base[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  if(!_begin(lanes, metric, arg))
+    return 0;
+  uint16_t points = _sweep(base, 16, 1, true);
+  if(_status == BUS_OK)
+    _write(_best);
+  return points;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sweeps a coarse EQ grid, then refines EQ around the best point
+            The coarse pass visits every eq_step-th EQ value with all
+            flat gain and swing settings. The fine pass keeps each lane's
+            best flat gain and swing and visits the EQ values within
+            eq_step - 1 of its best coarse EQ.
+    @param  lanes
+            Bit mask of the lanes to tune.
+    @param  eq_step
+            Coarse EQ step, 1 to 16.
+    @param  metric
+            Quality metric, called once per lane and point.
+    @param  arg
+            Passed to the metric.
+    @return Number of points visited, see status() for bus errors.
+*/
+/**************************************************************************/
+uint16_t SweepEngine::runCoarseFine(uint8_t lanes, uint8_t eq_step, Metric metric, void* arg){
+  int8_t base[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  if(eq_step < 1)
+    eq_step = 1;
+  if(eq_step > 16)
+    eq_step = 16;
+  if(!_begin(lanes, metric, arg))
+    return 0;
+  uint16_t points = _sweep(base, (16 + eq_step - 1) / eq_step, eq_step, true);
+  if(eq_step > 1 && _done != _lanes && _status == BUS_OK){
+    for(uint8_t i=0; i<8; i++)
+      base[i] = (int8_t)(_best[i] >> EQ_SHIFT) - (eq_step - 1);
+    if(_write(_best))
+      points += _sweep(base, 2 * eq_step - 1, 1, false);
+  }
+  if(_status == BUS_OK)
+    _write(_best);
+  return points;
+}
+
+// Loads the config bytes of all lanes; without them a burst would write
+// zeros to the lanes that are not swept
+bool SweepEngine::_begin(uint8_t lanes, Metric metric, void* arg){
+  uint8_t data[REG_COUNT];
+  _writes = 0;
+  _status = _rd->read(REG_BIT(CONFIG_A0_REG) | REG_BIT(CONFIG_B3_REG), data);
+  if(_status != BUS_OK)
+    return false;
+  for(uint8_t i=0; i<8; i++){
+    _cfg[i] = data[CONFIG_A_OFFSET + i];
+    _best[i] = _cfg[i];
+    _best_metric[i] = (int32_t)0x80000000;
+  }
+  _metric = metric;
+  _arg = arg;
+  _lanes = lanes;
+  _done = 0;
+  return true;
+}
+
+uint16_t SweepEngine::_sweep(const int8_t* eq_base, uint8_t eq_count, uint8_t eq_step, bool fg_sw){
+  // Digits from fastest to slowest: swing, flat gain, EQ
+  uint8_t radix[3] = {(uint8_t)(fg_sw ? 2 : 1), (uint8_t)(fg_sw ? 4 : 1), eq_count};
+  uint8_t digit[3] = {0, 0, 0};
+  int8_t dir[3] = {1, 1, 1};
+  uint16_t points = 0;
+  for(;;){
+    uint8_t cfg[8];
+    uint8_t valid = 0;
+    for(uint8_t lane=0; lane<8; lane++){
+      uint8_t i = _slot(lane);
+      cfg[i] = _cfg[i];
+      if(!(_lanes & ~_done & (1 << lane)))
+        continue;
+      int8_t eq = eq_base[i] + digit[2] * eq_step;
+      if(eq < 0 || eq > 15)
+        continue;
+      uint8_t value = (cfg[i] & ~EQ_MASK) | (eq << EQ_SHIFT);
+      if(fg_sw)
+        value = (value & ~(FG_MASK | SW_MASK)) | (digit[1] << FG_SHIFT) | (digit[0] << SW_SHIFT);
+      cfg[i] = value;
+      valid |= 1 << lane;
+    }
+    if(valid){
+      if(!_write(cfg))
+        break;
+      if(_settle)
+        delay(_settle);
+      points++;
+      for(uint8_t lane=0; lane<8; lane++){
+        if(!(valid & (1 << lane)))
+          continue;
+        uint8_t i = _slot(lane);
+        int32_t m = _metric(lane, cfg[i], _arg);
+        if(m > _best_metric[i]){
+          _best_metric[i] = m;
+          _best[i] = cfg[i];
+        }
+        if(m >= _target)
+          _done |= 1 << lane;
+      }
+      if(!(_lanes & ~_done))
+        break;
+    }
+    uint8_t j = 0;
+    while(j < 3 && (digit[j] + dir[j] < 0 || digit[j] + dir[j] >= radix[j])){
+      dir[j] = -dir[j];
+      j++;
+    }
+    if(j == 3)
+      break;
+    digit[j] += dir[j];
+  }
+  return points;
+}
+
+// Writes the config bytes that differ from the chip; _cfg follows only
+// writes that succeeded
+bool SweepEngine::_write(const uint8_t* cfg){
+  uint8_t data[8];
+  uint8_t first = 8, last = 0;
+  for(uint8_t i=0; i<8; i++){
+    if(cfg[i] == _cfg[i])
+      continue;
+    if(first == 8)
+      first = i;
+    last = i;
+  }
+  if(first == 8)
+    return true;
+  for(uint8_t i=first; i<=last; i++)
+    data[i] = cfg[i];
+  _writes++;
+  _status = _rd->_burst_write(CONFIG_A_OFFSET + first, &data[first], last - first + 1);
+  if(_status != BUS_OK)
+    return false;
+  for(uint8_t i=first; i<=last; i++)
+    _cfg[i] = cfg[i];
+  return true;
+}
@@ -0,0 +1,73 @@
+/*!
+ * @file SweepEngine.h
+ *
+ * EQ / flat gain / swing sweep for tuning PI3EQX12908 channels against
+ * a user-supplied quality metric.
+ *
+ * Written by Salman Motlaq (@SMotlaq on GitHub)
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _SWEEP_ENGINE_H
+#define _SWEEP_ENGINE_H
+
+#include "PI3EQX12908A2.h"
+
+#define SWEEP_ALL_LANES   0xFF        ///< Lane mask of all 8 channels
+#define SWEEP_NO_TARGET   0x7FFFFFFF  ///< Target that disables early termination
+
+/**************************************************************************/
+/*! 
+    @brief  Class that sweeps the EQ/FG/SW space of a set of lanes
+            Lanes are the register bits (A0..A3 = 4..7, B0..B3 = 0..3)
+            and are swept in parallel: every point is written to all
+            active lanes, then the metric is called once per lane.
+            Points are visited in reflected Gray order (swing fastest,
+            then flat gain, then EQ), so consecutive points differ in one
+            field of each config byte. Every step is a single write of
+            whole config bytes covering the lanes that changed; the
+            reserved bit 1 is carried over from the value read at start.
+            Higher metric values are better. A failed read at start or a
+            failed write stops the sweep where it is; status() tells.
+*/
+/**************************************************************************/
+class SweepEngine{
+  public:
+    /*! @brief Quality metric of a lane at its current config byte */
+    typedef int32_t (*Metric)(uint8_t lane, uint8_t config, void* arg);
+
+    SweepEngine(PI3EQX12908& rd);
+
+    void setTarget(int32_t target) { _target = target; }   ///< Stops sweeping a lane once its metric reaches target
+    void setSettle(uint16_t ms) { _settle = ms; }          ///< Delay between a write and the metric calls
+    uint16_t run(uint8_t lanes, Metric metric, void* arg = NULL);
+    uint16_t runCoarseFine(uint8_t lanes, uint8_t eq_step, Metric metric, void* arg = NULL);
+
+    uint8_t best(uint8_t lane) const { return _best[_slot(lane)]; }            ///< Best config byte found for a lane
+    int32_t bestMetric(uint8_t lane) const { return _best_metric[_slot(lane)]; } ///< Metric of best()
+    uint16_t writes() const { return _writes; }                               ///< Write transactions of the last run
+    uint8_t status() const { return _status; }                                ///< BUS_* status of the last run
+
+  private:
+    PI3EQX12908* _rd;
+    Metric       _metric;
+    void*        _arg;
+    int32_t      _target;
+    uint16_t     _settle;
+    uint16_t     _writes;
+    uint8_t      _lanes;
+    uint8_t      _done;
+    uint8_t      _status;
+    uint8_t      _cfg[8];
+    uint8_t      _best[8];
+    int32_t      _best_metric[8];
+
+    static uint8_t _slot(uint8_t lane) { return (lane + 4) & 7; }
+    bool _begin(uint8_t lanes, Metric metric, void* arg);
+    uint16_t _sweep(const int8_t* eq_base, uint8_t eq_count, uint8_t eq_step, bool fg_sw);
+    bool _write(const uint8_t* cfg);
+};
+
+#endif
@@ -0,0 +1,29 @@
+#include <Wire.h>
+#include <PI3EQX12908A2.h>
+#include <RedriverConfig.h>
+
+// The whole configuration is computed by the compiler and kept in flash
+constexpr RedriverConfig CFG = RedriverConfig()
+  .eqAll<0>()                               // Setting EQ for all channels
+  .fgAll<FLAT_GAIN_00db>()                  // Setting flat gain for all channels
+  .swAll<SWING_900mVpp>()                   // Setting swing for all channels
+  .eq<BANK_A, 2, 8>()                       // Setting EQ of channel A2
+  .sdt<SDT_OFF_30_ON_130_mVpp>();           // Setting signal detect threshold
+const uint8_t IMAGE[SHADOW_LEN] PROGMEM = REDRIVER_CONFIG_IMAGE(CFG);
+
+PI3EQX12908 RD;
+
+void setup() {
+  Wire.begin();
+  Serial.begin(115200);
+ 
+  delay(1000);
+  Serial.println("\n\r -------- CONFIGURATION --------");
+    RD.init(0x70);                            // Setting the I2C address
+    RD.writeImage_P(IMAGE);                   // One burst write of registers 2 to 13
+    RD.print_all();                           // Print all of the registers
+}
+
+void loop() {
+ 
+}
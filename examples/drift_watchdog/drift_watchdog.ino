@@ -0,0 +1,38 @@
+#include <Wire.h>
+#include <PI3EQX12908A2.h>
+#include <DriftWatchdog.h>
+
+PI3EQX12908 RD;
+DriftWatchdog watchdog;
+uint8_t expected[SHADOW_LEN];
+
+void on_drift(uint8_t index, uint16_t mask, uint8_t result, void*){
+  Serial.print("Redriver ");
+  Serial.print(index);
+  Serial.print(result == DRIFT_HEALED ? " healed, registers 0x" : " NOT healed, registers 0x");
+  Serial.println(mask, HEX);
+}
+
+void setup() {
+  Wire.begin();
+  Serial.begin(115200);
+ 
+  delay(1000);
+  Serial.println("\n\r -------- DRIFT WATCHDOG --------");
+    RD.init(0x70);
+    RD.setEQ(6);
+    RD.setFG(FLAT_GAIN_00db);
+    RD.readImage(expected);                   // The configuration to keep
+    watchdog.add(RD, expected);
+    watchdog.setPeriod(500);                  // One 14 byte read every 500 ms
+    watchdog.setCallback(on_drift);
+
+    PI3EQX12908 other;                        // Stand-in for a chip reset: change
+    other.init(0x70);                         // two registers behind the driver's back
+    other.setEQ_A1(0);
+    other.setEQ_B2(0);
+}
+
+void loop() {
+  watchdog.update();                          // Rewrites CONFIG_A1 and CONFIG_B2 only
+}
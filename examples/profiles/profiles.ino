@@ -0,0 +1,40 @@
+#include <Wire.h>
+#include <PI3EQX12908A2.h>
+#include <RedriverProfile.h>
+
+// Profiles are kept in a RAM buffer here. To keep them in EEPROM, include
+// <EEPROM.h> before RedriverProfile.h and use profileEepromRead/Write.
+uint8_t storage[2 * PROFILE_SIZE];
+ProfileStore store(profileBufferRead, profileBufferWrite, storage, 0, 2);
+
+PI3EQX12908 RD;
+
+void save_profile(uint8_t slot, const char* name, uint8_t EQ, uint8_t flat_gain){
+  RedriverProfile profile;
+  RD.setEQ(EQ);                             // Build the configuration once
+  RD.setFG(flat_gain);
+  RD.captureProfile(profile);               // Read registers 2 to 13
+  profile.setName(name);
+  profile.revision = 1;
+  store.save(slot, profile);
+}
+
+void setup() {
+  Wire.begin();
+  Serial.begin(115200);
+ 
+  delay(1000);
+  Serial.println("\n\r -------- PROFILES --------");
+    RD.init(0x70);                            // Setting the I2C address
+    save_profile(0, "short", 2, FLAT_GAIN_00db);
+    save_profile(1, "long", 12, FLAT_GAIN_P2db);
+
+    RedriverProfile profile;
+    if(store.loadByName("long", profile) == PROFILE_OK)
+      RD.applyProfile(profile);               // One burst write of registers 2 to 13
+    RD.print_all();                           // Print all of the registers
+}
+
+void loop() {
+ 
+}
@@ -0,0 +1,133 @@
+/*!
+ * @file Arduino.cpp
+ *
+ * Minimal Arduino core for building the library on a Linux host.
+ *
+ * MIT License
+ *
+ */
+
+#include "Arduino.h"
+#include <stdio.h>
+#include <time.h>
+
+HostSerial Serial;
+
+static uint64_t _now_us(){
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static const uint64_t _start_us = _now_us();
+
+unsigned long millis(){
+  return (_now_us() - _start_us) / 1000;
+}
+
+unsigned long micros(){
+  return _now_us() - _start_us;
+}
+
+void delay(unsigned long ms){
+  struct timespec ts = { (time_t)(ms / 1000), (long)(ms % 1000) * 1000000 };
+  nanosleep(&ts, NULL);
+}
+
+void delayMicroseconds(unsigned int us){
+  struct timespec ts = { (time_t)(us / 1000000), (long)(us % 1000000) * 1000 };
+  nanosleep(&ts, NULL);
+}
+
+// Open drain pins: a pin is low only while it is an output driven low
+#define HOST_PINS 64
+
+static uint8_t _pin_mode[HOST_PINS];
+static uint8_t _pin_out[HOST_PINS];
+static HostPinWrite _pin_write_hook = NULL;
+static HostPinRead _pin_read_hook = NULL;
+static void* _pin_hook_arg = NULL;
+
+static uint8_t _pin_level(uint8_t pin){
+  return _pin_mode[pin] == OUTPUT ? _pin_out[pin] : HIGH;
+}
+
+static void _pin_set(uint8_t pin, uint8_t mode, uint8_t out){
+  if(pin >= HOST_PINS)
+    return;
+  uint8_t before = _pin_level(pin);
+  _pin_mode[pin] = mode;
+  _pin_out[pin] = out;
+  uint8_t after = _pin_level(pin);
+  if(after != before && _pin_write_hook)
+    _pin_write_hook(pin, after, _pin_hook_arg);
+}
+
+void pinMode(uint8_t pin, uint8_t mode){
+  if(pin < HOST_PINS)
+    _pin_set(pin, mode, _pin_out[pin]);
+}
+
+void digitalWrite(uint8_t pin, uint8_t value){
+  if(pin < HOST_PINS)
+    _pin_set(pin, _pin_mode[pin], value ? HIGH : LOW);
+}
+
+int digitalRead(uint8_t pin){
+  if(pin >= HOST_PINS)
+    return LOW;
+  uint8_t level = _pin_level(pin);
+  if(_pin_read_hook && _pin_read_hook(pin, _pin_hook_arg) == LOW)
+    level = LOW;
+  return level;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Connects a simulated device to the host pins
+    @param  write
+            Called when the level driven on a pin changes.
+    @param  read
+            Gives the level the device puts on a pin.
+    @param  arg
+            Passed to both hooks.
+*/
+/**************************************************************************/
+void hostPinHooks(HostPinWrite write, HostPinRead read, void* arg){
+  _pin_write_hook = write;
+  _pin_read_hook = read;
+  _pin_hook_arg = arg;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size){
+  size_t n = 0;
+  while(size--)
+    n += write(*buffer++);
+  return n;
+}
+
+size_t Print::print(long n, int base){
+  if(n < 0 && base == DEC)
+    return write('-') + print((unsigned long)-n, base);
+  return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base){
+  char buf[8 * sizeof(long) + 1];
+  char* str = &buf[sizeof(buf) - 1];
+  *str = '\0';
+  do{
+    uint8_t digit = n % base;
+    n /= base;
+    *--str = digit < 10 ? '0' + digit : 'A' + digit - 10;
+  } while(n);
+  return write(str);
+}
+
+size_t HostSerial::write(uint8_t c){
+  return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HostSerial::write(const uint8_t* buffer, size_t size){
+  return fwrite(buffer, 1, size, stdout);
+}
@@ -0,0 +1,95 @@
+/*!
+ * @file Arduino.h
+ *
+ * Minimal Arduino core for building the library on a Linux host.
+ * It provides Serial on stdout, the timing functions and the PROGMEM
+ * helpers; nothing here is used by Arduino builds.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "String.h"
+
+#define HEX 16
+#define DEC 10
+
+#define PROGMEM
+#define PGM_P                 const char*
+#define PSTR(str)             (str)
+#define pgm_read_byte(addr)   (*(const uint8_t*)(addr))
+#define memcpy_P              memcpy
+#define strlen_P              strlen
+#define strcpy_P              strcpy
+
+class __FlashStringHelper;
+#define F(str)                ((const __FlashStringHelper*)(str))
+
+#define LOW           0
+#define HIGH          1
+#define INPUT         0
+#define OUTPUT        1
+#define INPUT_PULLUP  2
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+/*! @brief Host only: called whenever the level driven on a pin changes */
+typedef void (*HostPinWrite)(uint8_t pin, uint8_t level, void* arg);
+/*! @brief Host only: level an external device puts on a pin, HIGH if it leaves it alone */
+typedef uint8_t (*HostPinRead)(uint8_t pin, void* arg);
+void hostPinHooks(HostPinWrite write, HostPinRead read, void* arg);
+
+/**************************************************************************/
+/*! 
+    @brief  Subset of the Arduino Print class
+*/
+/**************************************************************************/
+class Print{
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+    size_t write(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+
+    size_t print(const char* str) { return write(str); }
+    size_t print(const String& str) { return write(str.c_str()); }
+    size_t print(const __FlashStringHelper* str) { return write((const char*)str); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t println() { return write("\r\n"); }
+    template <typename T> size_t println(T value) { return print(value) + println(); }
+    template <typename T> size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Serial port mapped to the standard output
+*/
+/**************************************************************************/
+class HostSerial : public Print{
+  public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* buffer, size_t size);
+    using Print::write;
+};
+
+extern HostSerial Serial;
+
+#endif
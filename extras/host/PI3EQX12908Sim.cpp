@@ -0,0 +1,361 @@
+/*!
+ * @file PI3EQX12908Sim.cpp
+ *
+ * Host-side simulation of an I2C bus and of the PI3EQX12908 redriver.
+ *
+ * MIT License
+ *
+ */
+
+#include "PI3EQX12908Sim.h"
+#include "PI3EQX12908A2.h"
+#include "Arduino.h"
+#include <stdio.h>
+#include <string.h>
+
+/**************************************************************************/
+/*!
+    @brief  Creates an empty bus running at 100 kHz
+*/
+/**************************************************************************/
+SimI2CBus::SimI2CBus()
+  : _hz(100000), _trace(false), _timeout_ns((uint64_t)SIM_DEFAULT_TIMEOUT_US * 1000), _fail_count(0),
+    _fail_status(BUS_OK), _stuck_clocks(0), _scl(0xFF), _sda(0xFF){
+  memset(_slots, 0, sizeof(_slots));
+  resetStats();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Sets the SCL frequency
+            100 kHz and below use standard mode timing, up to 400 kHz
+            fast mode and above that fast mode plus.
+    @param  hz
+            SCL frequency in Hz.
+*/
+/**************************************************************************/
+void SimI2CBus::setClock(uint32_t hz){
+  _hz = hz ? hz : 100000;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Attaches a device
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  device
+            The device. It must outlive the bus or be detached.
+    @return false if the bus is full.
+*/
+/**************************************************************************/
+bool SimI2CBus::attach(uint8_t i2c_addr, SimI2CDevice& device){
+  detach(i2c_addr);
+  for(uint8_t i=0; i<SIM_MAX_DEVICES; i++){
+    if(!_slots[i].device){
+      _slots[i].addr = i2c_addr;
+      _slots[i].device = &device;
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Detaches the device at a given address
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+*/
+/**************************************************************************/
+void SimI2CBus::detach(uint8_t i2c_addr){
+  for(uint8_t i=0; i<SIM_MAX_DEVICES; i++)
+    if(_slots[i].device && _slots[i].addr == i2c_addr)
+      _slots[i].device = NULL;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes the next transactions fail with a data NACK
+    @param  count
+            Number of transactions to fail.
+*/
+/**************************************************************************/
+void SimI2CBus::failNext(uint8_t count){
+  failNext(count, BUS_ERR_NACK_DATA);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes the next transactions fail
+    @param  count
+            Number of transactions to fail.
+    @param  status
+            BUS_* code they return.
+*/
+/**************************************************************************/
+void SimI2CBus::failNext(uint8_t count, uint8_t status){
+  _fail_count = count;
+  _fail_status = status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Makes a device hold SDA low
+            Until the device is clocked free, every transaction times out
+            after the bus timeout.
+    @param  clocks
+            SCL pulses the device needs to release SDA, 0 to release it
+            right away.
+*/
+/**************************************************************************/
+void SimI2CBus::setStuck(uint8_t clocks){
+  _stuck_clocks = clocks;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Connects the bus to host pins for bus recovery
+            SCL pulses on the pin count towards releasing a stuck device
+            and SDA reads low while the bus is stuck.
+    @param  scl
+            SCL pin number.
+    @param  sda
+            SDA pin number.
+*/
+/**************************************************************************/
+void SimI2CBus::attachPins(uint8_t scl, uint8_t sda){
+  _scl = scl;
+  _sda = sda;
+  hostPinHooks(_pin_write, _pin_read, this);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs a write transaction
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the bytes to send.
+    @param  len
+            Number of bytes to send.
+    @return One of the BUS_* status codes.
+*/
+/**************************************************************************/
+uint8_t SimI2CBus::write(uint8_t i2c_addr, const uint8_t* data, uint8_t len){
+  SimI2CDevice* device = _find(i2c_addr);
+  uint32_t ns;
+  uint8_t status = _fault(ns);
+  // An injected fault has been charged already
+  if(status == BUS_OK && !device){
+    status = BUS_ERR_NACK_ADDR;
+    ns = _charge(0);
+  }
+  else if(status == BUS_OK){
+    if(!device->i2cWrite(data, len))
+      status = BUS_ERR_NACK_DATA;
+    ns = _charge(len);
+  }
+  if(_trace)
+    fprintf(stderr, "[sim] W 0x%02X len=%2u status=%u %8.2f us\n", i2c_addr, len, status, ns / 1000.0);
+  return status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Runs a read transaction
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the array to store the bytes.
+    @param  len
+            Number of bytes to read.
+    @return One of the BUS_* status codes.
+*/
+/**************************************************************************/
+uint8_t SimI2CBus::read(uint8_t i2c_addr, uint8_t* data, uint8_t len){
+  SimI2CDevice* device = _find(i2c_addr);
+  uint32_t ns;
+  uint8_t status = _fault(ns);
+  // An injected fault has been charged already
+  if(status == BUS_OK && !device){
+    status = BUS_ERR_NACK_ADDR;
+    ns = _charge(0);
+  }
+  else if(status == BUS_OK){
+    if(!device->i2cRead(data, len))
+      status = BUS_ERR_NACK_DATA;
+    ns = _charge(len);
+  }
+  if(_trace)
+    fprintf(stderr, "[sim] R 0x%02X len=%2u status=%u %8.2f us\n", i2c_addr, len, status, ns / 1000.0);
+  return status;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Clears the bus usage counters
+*/
+/**************************************************************************/
+void SimI2CBus::resetStats(){
+  memset(&_stats, 0, sizeof(_stats));
+}
+
+/**************************************************************************/
+/*!
+    @brief  Bus usage since an earlier stats() copy
+            Take a copy of stats() before an API call and pass it here
+            afterwards to get the cost of that call alone.
+    @param  start
+            Counters taken before the measured code.
+    @return Difference of the counters.
+*/
+/**************************************************************************/
+SimI2CStats SimI2CBus::since(const SimI2CStats& start) const{
+  SimI2CStats delta;
+  delta.transactions = _stats.transactions - start.transactions;
+  delta.wire_bytes   = _stats.wire_bytes - start.wire_bytes;
+  delta.bus_ns       = _stats.bus_ns - start.bus_ns;
+  return delta;
+}
+
+SimI2CDevice* SimI2CBus::_find(uint8_t i2c_addr){
+  for(uint8_t i=0; i<SIM_MAX_DEVICES; i++)
+    if(_slots[i].device && _slots[i].addr == i2c_addr)
+      return _slots[i].device;
+  return NULL;
+}
+
+uint8_t SimI2CBus::_fault(uint32_t& ns){
+  if(_stuck_clocks){
+    _stats.transactions++;
+    _stats.bus_ns += _timeout_ns;
+    ns = (uint32_t)_timeout_ns;
+    return BUS_ERR_TIMEOUT;
+  }
+  if(_fail_count){
+    _fail_count--;
+    ns = _charge(0);
+    return _fail_status;
+  }
+  return BUS_OK;
+}
+
+void SimI2CBus::_pin_write(uint8_t pin, uint8_t level, void* arg){
+  SimI2CBus* bus = (SimI2CBus*)arg;
+  if(pin == bus->_scl && level == HIGH && bus->_stuck_clocks)
+    bus->_stuck_clocks--;
+}
+
+uint8_t SimI2CBus::_pin_read(uint8_t pin, void* arg){
+  SimI2CBus* bus = (SimI2CBus*)arg;
+  return pin == bus->_sda && bus->_stuck_clocks ? LOW : HIGH;
+}
+
+uint32_t SimI2CBus::_charge(uint8_t bytes){
+  // START hold, STOP setup and bus free times of the I2C specification
+  uint32_t t_hd_sta, t_su_sto, t_buf;
+  if(_hz <= 100000){
+    t_hd_sta = 4000; t_su_sto = 4000; t_buf = 4700;
+  }
+  else if(_hz <= 400000){
+    t_hd_sta = 600;  t_su_sto = 600;  t_buf = 1300;
+  }
+  else{
+    t_hd_sta = 260;  t_su_sto = 260;  t_buf = 500;
+  }
+  // Address byte plus data bytes, 8 bits and an ACK each
+  uint32_t cycles = 9 * (1 + (uint32_t)bytes);
+  uint32_t ns = t_hd_sta + (uint32_t)((uint64_t)cycles * 1000000000 / _hz) + t_su_sto + t_buf;
+  _stats.transactions++;
+  _stats.wire_bytes += 1 + bytes;
+  _stats.bus_ns += ns;
+  return ns;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Creates a redriver in its reset state
+*/
+/**************************************************************************/
+PI3EQX12908Sim::PI3EQX12908Sim(){
+  reset();
+}
+
+/**************************************************************************/
+/*!
+    @brief  Puts all registers back to their reset value
+*/
+/**************************************************************************/
+void PI3EQX12908Sim::reset(){
+  memset(_regs, 0, sizeof(_regs));
+  _amp_lanes = 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Models the received amplitude of a lane
+            From now on the lane's signal detect bit follows the
+            threshold register, with the chip's off/on hysteresis.
+    @param  lane
+            Lane bit (A0..A3 = 4..7, B0..B3 = 0..3).
+    @param  mVpp
+            Received amplitude.
+*/
+/**************************************************************************/
+void PI3EQX12908Sim::setAmplitude(uint8_t lane, uint16_t mVpp){
+  _amp[lane] = mVpp;
+  _amp_lanes |= 1 << lane;
+}
+
+void PI3EQX12908Sim::_detect(){
+  static const uint16_t off_mVpp[4] = {30, 50, 70, 110};
+  static const uint16_t on_mVpp[4] = {130, 150, 170, 210};
+  uint8_t level = (_regs[SIGNAL_DET_TH_REG] & SDT_MASK) >> SDT_SHIFT;
+  for(uint8_t i=0; i<8; i++){
+    uint8_t bit = 1 << i;
+    if(!(_amp_lanes & bit))
+      continue;
+    uint16_t threshold = (_regs[SIGNAL_DETECT_REG] & bit) ? off_mVpp[level] : on_mVpp[level];
+    if(_amp[i] >= threshold)
+      _regs[SIGNAL_DETECT_REG] |= bit;
+    else
+      _regs[SIGNAL_DETECT_REG] &= ~bit;
+  }
+}
+
+/**************************************************************************/
+/*!
+    @brief  Handles a write: register pointer followed by data
+    @param  data
+            A pointer to the received bytes.
+    @param  len
+            Number of received bytes.
+    @return Always true, writes to read-only registers are ignored.
+*/
+/**************************************************************************/
+bool PI3EQX12908Sim::i2cWrite(const uint8_t* data, uint8_t len){
+  if(!len)
+    return true;
+  uint8_t reg = data[0];
+  for(uint8_t i=1; i<len; i++, reg++)
+    if(reg >= POWER_DOWN_REG && reg <= SIGNAL_DET_TH_REG)
+      _regs[reg] = data[i];
+  return true;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Handles a read: the chip always answers from register 0
+    @param  data
+            A pointer to the array to store the bytes.
+    @param  len
+            Number of bytes requested.
+    @return Always true.
+*/
+/**************************************************************************/
+bool PI3EQX12908Sim::i2cRead(uint8_t* data, uint8_t len){
+  _detect();
+  for(uint8_t i=0; i<len; i++)
+    data[i] = i < sizeof(_regs) ? _regs[i] : 0xFF;
+  return true;
+}
@@ -0,0 +1,134 @@
+/*!
+ * @file PI3EQX12908Sim.h
+ *
+ * Host-side simulation of an I2C bus and of the PI3EQX12908 redriver.
+ * The bus charges every transaction with the SCL cycles and the start,
+ * stop and bus-free times of the selected I2C mode, so the library can
+ * be measured without hardware. The simulated Wire object (Wire.h in this
+ * directory) sits on top of it.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _PI3EQX12908_SIM_H
+#define _PI3EQX12908_SIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SIM_MAX_DEVICES 8   ///< Devices per simulated bus
+#define SIM_DEFAULT_TIMEOUT_US 25000 ///< Time a transaction on a stuck bus takes to time out
+
+/**************************************************************************/
+/*! 
+    @brief  A device on the simulated I2C bus
+*/
+/**************************************************************************/
+class SimI2CDevice{
+  public:
+    virtual ~SimI2CDevice() {}
+    /*! @brief Handles a write transaction, returns false to NACK */
+    virtual bool i2cWrite(const uint8_t* data, uint8_t len) = 0;
+    /*! @brief Handles a read transaction, returns false to NACK */
+    virtual bool i2cRead(uint8_t* data, uint8_t len) = 0;
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Bus usage counters of a simulated bus
+*/
+/**************************************************************************/
+struct SimI2CStats{
+  uint32_t transactions;  ///< Number of START..STOP transactions
+  uint32_t wire_bytes;    ///< Bytes clocked on the bus, address bytes included
+  uint64_t bus_ns;        ///< Simulated bus time in nanoseconds
+
+  /*! @brief Simulated bus time in microseconds */
+  double micros() const { return bus_ns / 1000.0; }
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Simulated I2C bus with a timing model
+*/
+/**************************************************************************/
+class SimI2CBus{
+  public:
+    SimI2CBus();
+
+    void setClock(uint32_t hz);
+    uint32_t getClock() const { return _hz; }
+    bool attach(uint8_t i2c_addr, SimI2CDevice& device);
+    void detach(uint8_t i2c_addr);
+    void setTrace(bool enable) { _trace = enable; }
+    void setTimeout(uint32_t us) { _timeout_ns = (uint64_t)us * 1000; }  ///< Time a transaction on a stuck bus takes
+    void failNext(uint8_t count);
+    void failNext(uint8_t count, uint8_t status);
+    void setStuck(uint8_t clocks);
+    bool stuck() const { return _stuck_clocks != 0; }               ///< true while a device holds SDA low
+    void attachPins(uint8_t scl, uint8_t sda);
+
+    uint8_t write(uint8_t i2c_addr, const uint8_t* data, uint8_t len);
+    uint8_t read(uint8_t i2c_addr, uint8_t* data, uint8_t len);
+
+    const SimI2CStats& stats() const { return _stats; }
+    SimI2CStats since(const SimI2CStats& start) const;
+    void resetStats();
+
+  private:
+    struct Slot{
+      uint8_t addr;
+      SimI2CDevice* device;
+    };
+
+    Slot        _slots[SIM_MAX_DEVICES];
+    uint32_t    _hz;
+    bool        _trace;
+    SimI2CStats _stats;
+    uint64_t    _timeout_ns;
+    uint8_t     _fail_count;
+    uint8_t     _fail_status;
+    uint8_t     _stuck_clocks;
+    uint8_t     _scl;
+    uint8_t     _sda;
+
+    SimI2CDevice* _find(uint8_t i2c_addr);
+    uint32_t _charge(uint8_t bytes);
+    uint8_t _fault(uint32_t& ns);
+    static void _pin_write(uint8_t pin, uint8_t level, void* arg);
+    static uint8_t _pin_read(uint8_t pin, void* arg);
+};
+
+/**************************************************************************/
+/*! 
+    @brief  Simulated PI3EQX12908 register map
+            Reads always start at register 0, writes take the register
+            pointer as first byte and auto-increment. Signal detect and
+            RX detect are read only and driven with setSignalDetect()
+            and setRxDetect().
+*/
+/**************************************************************************/
+class PI3EQX12908Sim : public SimI2CDevice{
+  public:
+    PI3EQX12908Sim();
+
+    void reset();
+    void setSignalDetect(uint8_t value) { _regs[0] = value; }
+    void setRxDetect(uint8_t value) { _regs[1] = value; }
+    void setAmplitude(uint8_t lane, uint16_t mVpp);
+    uint8_t reg(uint8_t mem_addr) const { return _regs[mem_addr]; }
+    void poke(uint8_t mem_addr, uint8_t value) { _regs[mem_addr] = value; }
+
+    bool i2cWrite(const uint8_t* data, uint8_t len);
+    bool i2cRead(uint8_t* data, uint8_t len);
+
+  private:
+    uint8_t  _regs[16];
+    uint8_t  _amp_lanes;
+    uint16_t _amp[8];
+
+    void _detect();
+};
+
+#endif
@@ -0,0 +1,113 @@
+/*!
+ * @file PI3EQX12908_LinuxBus.cpp
+ *
+ * Linux i2c-dev transport for the PI3EQX12908 library.
+ *
+ * MIT License
+ *
+ */
+
+#include "PI3EQX12908_LinuxBus.h"
+#include "PI3EQX12908A2.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+
+/**************************************************************************/
+/*!
+    @brief  Opens an i2c-dev device
+    @param  device
+            Path of the device, e.g. "/dev/i2c-1".
+    @return true on success.
+*/
+/**************************************************************************/
+bool PI3EQX12908_LinuxBus::begin(const char* device){
+  end();
+  _fd = open(device, O_RDWR);
+  return _fd >= 0;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Opens an i2c-dev adapter by number
+    @param  adapter
+            Adapter number N of /dev/i2c-N.
+    @return true on success.
+*/
+/**************************************************************************/
+bool PI3EQX12908_LinuxBus::begin(int adapter){
+  char device[32];
+  snprintf(device, sizeof(device), "/dev/i2c-%d", adapter);
+  return begin(device);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Closes the device
+*/
+/**************************************************************************/
+void PI3EQX12908_LinuxBus::end(){
+  if(_fd >= 0)
+    close(_fd);
+  _fd = -1;
+}
+
+/**************************************************************************/
+/*!
+    @brief  Writes a buffer to a device with one I2C_RDWR call
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the bytes to send.
+    @param  len
+            Number of bytes to send.
+    @return One of the BUS_* status codes.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908_LinuxBus::write(uint8_t i2c_addr, const uint8_t* data, uint8_t len){
+  return _transfer(i2c_addr, 0, (uint8_t*)data, len);
+}
+
+/**************************************************************************/
+/*!
+    @brief  Reads a buffer from a device with one I2C_RDWR call
+    @param  i2c_addr
+            The 7 bit I2C address of the device.
+    @param  data
+            A pointer to the array to store the bytes.
+    @param  len
+            Number of bytes to read.
+    @return One of the BUS_* status codes.
+*/
+/**************************************************************************/
+uint8_t PI3EQX12908_LinuxBus::read(uint8_t i2c_addr, uint8_t* data, uint8_t len){
+  return _transfer(i2c_addr, I2C_M_RD, data, len);
+}
+
+uint8_t PI3EQX12908_LinuxBus::_transfer(uint8_t i2c_addr, uint16_t flags, uint8_t* data, uint8_t len){
+  if(_fd < 0)
+    return BUS_ERR_OTHER;
+  struct i2c_msg msg;
+  msg.addr  = i2c_addr;
+  msg.flags = flags;
+  msg.len   = len;
+  msg.buf   = data;
+  struct i2c_rdwr_ioctl_data xfer;
+  xfer.msgs  = &msg;
+  xfer.nmsgs = 1;
+  if(ioctl(_fd, I2C_RDWR, &xfer) == 1)
+    return BUS_OK;
+  switch(errno){
+    case ENXIO:
+    case EREMOTEIO: return BUS_ERR_NACK_ADDR;
+    case ETIMEDOUT: return BUS_ERR_TIMEOUT;
+    case EINVAL:
+    case EMSGSIZE:  return BUS_ERR_TOO_LONG;
+    default:        return BUS_ERR_OTHER;
+  }
+}
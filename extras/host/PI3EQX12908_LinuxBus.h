@@ -0,0 +1,47 @@
+/*!
+ * @file PI3EQX12908_LinuxBus.h
+ *
+ * Linux i2c-dev transport for the PI3EQX12908 library. Every read and
+ * write of the driver is issued as one I2C_RDWR ioctl on /dev/i2c-N.
+ *
+ * Build the library with
+ *   -DPI3EQX12908_BUS_HEADER='"PI3EQX12908_LinuxBus.h"'
+ * to use it (see the Makefile in this directory).
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _PI3EQX12908_LINUXBUS_H
+#define _PI3EQX12908_LINUXBUS_H
+
+#include <stdint.h>
+
+/**************************************************************************/
+/*! 
+    @brief  Transport over a Linux i2c-dev adapter
+*/
+/**************************************************************************/
+class PI3EQX12908_LinuxBus{
+  public:
+    PI3EQX12908_LinuxBus() : _fd(-1) {}
+    ~PI3EQX12908_LinuxBus() { end(); }
+
+    bool begin(const char* device);
+    bool begin(int adapter);
+    void end();
+    uint8_t write(uint8_t i2c_addr, const uint8_t* data, uint8_t len);
+    uint8_t read(uint8_t i2c_addr, uint8_t* data, uint8_t len);
+    bool recover() { return false; } ///< The i2c-dev interface leaves bus recovery to the adapter driver
+
+  private:
+    int _fd;
+
+    uint8_t _transfer(uint8_t i2c_addr, uint16_t flags, uint8_t* data, uint8_t len);
+};
+
+#ifndef PI3EQX12908_BUS
+#define PI3EQX12908_BUS PI3EQX12908_LinuxBus
+#endif
+
+#endif
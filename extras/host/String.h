@@ -0,0 +1,31 @@
+/*!
+ * @file String.h
+ *
+ * Minimal stand-in for the Arduino String class, used by host builds
+ * of the library only.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _HOST_STRING_H
+#define _HOST_STRING_H
+
+#include <string>
+
+/**************************************************************************/
+/*! 
+    @brief  Subset of the Arduino String class used by the library
+*/
+/**************************************************************************/
+class String{
+  public:
+    String(const char* str = "") : _str(str) {}
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+
+  private:
+    std::string _str;
+};
+
+#endif
@@ -0,0 +1,65 @@
+/*!
+ * @file Wire.cpp
+ *
+ * Arduino TwoWire API on top of the simulated I2C bus.
+ *
+ * MIT License
+ *
+ */
+
+#include "Wire.h"
+#include "PI3EQX12908A2.h"
+
+TwoWire Wire;
+TwoWire Wire1;
+
+TwoWire::TwoWire() : _tx_addr(0), _tx_len(0), _tx_overflow(false), _rx_len(0), _rx_pos(0), _timeout_flag(false){
+}
+
+void TwoWire::beginTransmission(uint8_t address){
+  _tx_addr = address;
+  _tx_len = 0;
+  _tx_overflow = false;
+}
+
+uint8_t TwoWire::endTransmission(bool stop){
+  (void)stop;
+  if(_tx_overflow)
+    return 1;
+  uint8_t status = _bus.write(_tx_addr, _tx, _tx_len);
+  if(status == BUS_ERR_TIMEOUT)
+    _timeout_flag = true;
+  return status;
+}
+
+size_t TwoWire::write(uint8_t data){
+  if(_tx_len >= BUFFER_LENGTH){
+    _tx_overflow = true;
+    return 0;
+  }
+  _tx[_tx_len++] = data;
+  return 1;
+}
+
+size_t TwoWire::write(const uint8_t* data, size_t quantity){
+  size_t n = 0;
+  while(n < quantity && write(data[n]))
+    n++;
+  return n;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool stop){
+  (void)stop;
+  if(quantity > BUFFER_LENGTH)
+    quantity = BUFFER_LENGTH;
+  _rx_pos = 0;
+  uint8_t status = _bus.read(address, _rx, quantity);
+  if(status == BUS_ERR_TIMEOUT)
+    _timeout_flag = true;
+  _rx_len = status == BUS_OK ? quantity : 0;
+  return _rx_len;
+}
+
+int TwoWire::read(){
+  return _rx_pos < _rx_len ? _rx[_rx_pos++] : -1;
+}
@@ -0,0 +1,63 @@
+/*!
+ * @file Wire.h
+ *
+ * Arduino TwoWire API on top of the simulated I2C bus, so the library
+ * and its examples run unchanged on a Linux host. Devices are attached
+ * with Wire.bus().attach(...).
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _HOST_WIRE_H
+#define _HOST_WIRE_H
+
+#include "Arduino.h"
+#include "PI3EQX12908Sim.h"
+
+#define BUFFER_LENGTH 32  ///< Size of the transmit and receive buffers, as on AVR
+#define WIRE_HAS_TIMEOUT  ///< setWireTimeout() is available, as on AVR
+
+/**************************************************************************/
+/*! 
+    @brief  TwoWire backed by a SimI2CBus
+*/
+/**************************************************************************/
+class TwoWire{
+  public:
+    TwoWire();
+
+    void begin() {}
+    void end() { _bus.setClock(100000); } ///< Like on the AVR core, the next begin() runs at the default 100 kHz
+    void setClock(uint32_t hz) { _bus.setClock(hz); }
+    void setWireTimeout(uint32_t us = 25000, bool reset = false) { (void)reset; _bus.setTimeout(us); } ///< Timeout of a transaction on a stuck bus
+    bool getWireTimeoutFlag() const { return _timeout_flag; }  ///< true if a transaction timed out since the last clear
+    void clearWireTimeoutFlag() { _timeout_flag = false; }     ///< Clears getWireTimeoutFlag()
+    SimI2CBus& bus() { return _bus; }
+
+    void beginTransmission(uint8_t address);
+    void beginTransmission(int address) { beginTransmission((uint8_t)address); }
+    uint8_t endTransmission(bool stop = true);
+    size_t write(uint8_t data);
+    size_t write(const uint8_t* data, size_t quantity);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool stop = true);
+    uint8_t requestFrom(int address, int quantity) { return requestFrom((uint8_t)address, (uint8_t)quantity); }
+    int available() { return _rx_len - _rx_pos; }
+    int read();
+
+  private:
+    SimI2CBus _bus;
+    uint8_t   _tx_addr;
+    uint8_t   _tx[BUFFER_LENGTH];
+    uint8_t   _tx_len;
+    bool      _tx_overflow;
+    uint8_t   _rx[BUFFER_LENGTH];
+    uint8_t   _rx_len;
+    uint8_t   _rx_pos;
+    bool      _timeout_flag;
+};
+
+extern TwoWire Wire;
+extern TwoWire Wire1;
+
+#endif
@@ -0,0 +1,409 @@
+/*!
+ * @file bench.cpp
+ *
+ * Bus-cost regression benchmark. Every public API of the library is run
+ * against the simulated chip at 400 kHz, once without and once with the
+ * shadow cache, and the number of transactions, bytes on the wire and
+ * simulated bus time are compared against a golden table. Any increase
+ * fails the run. Every step of the asynchronous API is also checked
+ * against ASYNC_STEP_BUDGET_NS.
+ *
+ *   bench <golden>            compare against the golden table
+ *   bench <golden> --update   rewrite the golden table
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "Wire.h"
+#include "PI3EQX12908A2.h"
+#include "RedriverFleet.h"
+#include "PI3EQX12908Async.h"
+#include "LinkMonitor.h"
+#include "LanePowerPolicy.h"
+#include "SweepEngine.h"
+#include "RedriverProfile.h"
+#include "RedriverConfig.h"
+#include "DriftWatchdog.h"
+
+#define BENCH_CLOCK   400000
+#define BENCH_MAX     512
+
+// One full register dump at BENCH_CLOCK: the longest single transaction
+#define ASYNC_STEP_BUDGET_NS  385000
+
+typedef void (*BenchFn)(PI3EQX12908& rd, uint8_t* data, RedriverState& state);
+
+struct Bench{
+  const char* name;
+  BenchFn     run;
+};
+
+struct Result{
+  char        mode[8];
+  char        name[128];
+  SimI2CStats stats;
+};
+
+// Flat metric: sweeps always visit every point
+static int32_t sweep_metric(uint8_t, uint8_t, void*){ return 0; }
+
+#define SCENARIO(label, ...) { label, [](PI3EQX12908& rd, uint8_t* data, RedriverState& state){ (void)data; (void)state; __VA_ARGS__; } }
+#define API(...) SCENARIO(#__VA_ARGS__, rd.__VA_ARGS__)
+
+static const Bench BENCHES[] = {
+  API(print_all()),
+  API(dump_all(data)),
+  API(snapshot(state)),
+  API(setCache(true)),
+  API(resync()),
+  API(invalidate()),
+  API(beginTransaction()),
+  API(commit()),
+  API(prefetch(REG_BIT(CONFIG_A0_REG) | REG_BIT(SIGNAL_DET_TH_REG))),
+  API(read(REG_BIT(CONFIG_A0_REG) | REG_BIT(SIGNAL_DET_TH_REG), data)),
+  API(getSignalDetect()),
+  API(getSignalDetect_A()),
+  API(getSignalDetect_A(1)),
+  API(getSignalDetect_B()),
+  API(getSignalDetect_B(1)),
+  API(getRxDetect()),
+  API(getRxDetect_A()),
+  API(getRxDetect_A(1)),
+  API(getRxDetect_B()),
+  API(getRxDetect_B(1)),
+  API(getPowerDown()),
+  API(getPowerDown_A()),
+  API(getPowerDown_A(1)),
+  API(getPowerDown_B()),
+  API(getPowerDown_B(1)),
+  API(setPowerDown(CFG_OFF)),
+  API(setPowerDown_A(CFG_OFF)),
+  API(setPowerDown_A(1, CFG_OFF)),
+  API(setPowerDown_B(CFG_OFF)),
+  API(setPowerDown_B(1, CFG_OFF)),
+  API(getConfig_A0()),
+  API(getEQ_A0()),
+  API(getFlatGain_A0()),
+  API(getSW_A0()),
+  API(setConfig_A0(0x5D)),
+  API(setEQ_A0(5)),
+  API(setFlatGain_A0(FLAT_GAIN_P2db)),
+  API(setSW_A0(SWING_1000mVpp)),
+  API(getConfig_A1()),
+  API(getEQ_A1()),
+  API(getFlatGain_A1()),
+  API(getSW_A1()),
+  API(setConfig_A1(0x5D)),
+  API(setEQ_A1(5)),
+  API(setFlatGain_A1(FLAT_GAIN_P2db)),
+  API(setSW_A1(SWING_1000mVpp)),
+  API(getConfig_A2()),
+  API(getEQ_A2()),
+  API(getFlatGain_A2()),
+  API(getSW_A2()),
+  API(setConfig_A2(0x5D)),
+  API(setEQ_A2(5)),
+  API(setFlatGain_A2(FLAT_GAIN_P2db)),
+  API(setSW_A2(SWING_1000mVpp)),
+  API(getConfig_A3()),
+  API(getEQ_A3()),
+  API(getFlatGain_A3()),
+  API(getSW_A3()),
+  API(setConfig_A3(0x5D)),
+  API(setEQ_A3(5)),
+  API(setFlatGain_A3(FLAT_GAIN_P2db)),
+  API(setSW_A3(SWING_1000mVpp)),
+  API(getConfig_B0()),
+  API(getEQ_B0()),
+  API(getFlatGain_B0()),
+  API(getSW_B0()),
+  API(setConfig_B0(0x5D)),
+  API(setEQ_B0(5)),
+  API(setFlatGain_B0(FLAT_GAIN_P2db)),
+  API(setSW_B0(SWING_1000mVpp)),
+  API(getConfig_B1()),
+  API(getEQ_B1()),
+  API(getFlatGain_B1()),
+  API(getSW_B1()),
+  API(setConfig_B1(0x5D)),
+  API(setEQ_B1(5)),
+  API(setFlatGain_B1(FLAT_GAIN_P2db)),
+  API(setSW_B1(SWING_1000mVpp)),
+  API(getConfig_B2()),
+  API(getEQ_B2()),
+  API(getFlatGain_B2()),
+  API(getSW_B2()),
+  API(setConfig_B2(0x5D)),
+  API(setEQ_B2(5)),
+  API(setFlatGain_B2(FLAT_GAIN_P2db)),
+  API(setSW_B2(SWING_1000mVpp)),
+  API(getConfig_B3()),
+  API(getEQ_B3()),
+  API(getFlatGain_B3()),
+  API(getSW_B3()),
+  API(setConfig_B3(0x5D)),
+  API(setEQ_B3(5)),
+  API(setFlatGain_B3(FLAT_GAIN_P2db)),
+  API(setSW_B3(SWING_1000mVpp)),
+  API(getSignalDetectConfig()),
+  API(getSignalDetectConfig_A()),
+  API(getSignalDetectConfig_A(1)),
+  API(getSignalDetectConfig_B()),
+  API(getSignalDetectConfig_B(1)),
+  API(setSignalDetectConfig(CFG_OFF)),
+  API(setSignalDetectConfig_A(CFG_OFF)),
+  API(setSignalDetectConfig_A(1, CFG_OFF)),
+  API(setSignalDetectConfig_B(CFG_OFF)),
+  API(setSignalDetectConfig_B(1, CFG_OFF)),
+  API(getRxDetectConfig()),
+  API(getRxDetectConfig_A()),
+  API(getRxDetectConfig_A(1)),
+  API(getRxDetectConfig_B()),
+  API(getRxDetectConfig_B(1)),
+  API(setRxDetectConfig(CFG_OFF)),
+  API(setRxDetectConfig_A(CFG_OFF)),
+  API(setRxDetectConfig_A(1, CFG_OFF)),
+  API(setRxDetectConfig_B(CFG_OFF)),
+  API(setRxDetectConfig_B(1, CFG_OFF)),
+  API(getSDTConfig()),
+  API(setSDTConfig(SDT_OFF_70_ON_170_mVpp)),
+  API(setConfig_A(0x5D)),
+  API(setConfig_A(1, 0x5D)),
+  API(setConfig_B(0x5D)),
+  API(setConfig_B(1, 0x5D)),
+  API(setConfig(0x5D)),
+  API(setEQ_A(5)),
+  API(setEQ_B(5)),
+  API(setEQ(5)),
+  API(setFG_A(FLAT_GAIN_P2db)),
+  API(setFG_B(FLAT_GAIN_P2db)),
+  API(setFG(FLAT_GAIN_P2db)),
+  API(setSW_A(SWING_1000mVpp)),
+  API(setSW_B(SWING_1000mVpp)),
+  API(setSW(SWING_1000mVpp)),
+  API(print_all()),
+  API(dump_all(data)),
+  API(snapshot(state)),
+  SCENARIO("config_all sequence",
+    rd.setEQ(0); rd.setFG(FLAT_GAIN_00db); rd.setSW(SWING_900mVpp); rd.setSDTConfig(SDT_OFF_30_ON_130_mVpp)),
+  SCENARIO("config_by_index sequence",
+    rd.setEQ_A0(0); rd.setEQ_A1(2); rd.setEQ_A2(1); rd.setPowerDown_A(3, CFG_OFF); rd.setFG_A(FLAT_GAIN_00db);
+    rd.setSW_A(SWING_900mVpp); rd.setSDTConfig(SDT_OFF_30_ON_130_mVpp); rd.setPowerDown_B(CFG_OFF)),
+  SCENARIO("transaction of 8 EQ setters",
+    rd.beginTransaction(); rd.setEQ_A0(1); rd.setEQ_A1(2); rd.setEQ_A2(3); rd.setEQ_A3(4);
+    rd.setEQ_B0(5); rd.setEQ_B1(6); rd.setEQ_B2(7); rd.setEQ_B3(8); rd.commit()),
+  SCENARIO("channel<BANK_A, 1>().eq(5).gain(FLAT_GAIN_00db).swing(SWING_1000mVpp)",
+    rd.channel<BANK_A, 1>().eq(5).gain(FLAT_GAIN_00db).swing(SWING_1000mVpp)),
+  SCENARIO("channel(BANK_B, 2).setPowerDown(CFG_OFF)",
+    rd.channel(BANK_B, 2).setPowerDown(CFG_OFF)),
+  API(get<FIELD_EQ_B2>()),
+  API(set<FIELD_EQ_A0, FIELD_FG_A0, FIELD_SW_A0>(5, FLAT_GAIN_00db, SWING_1000mVpp)),
+  SCENARIO("RedriverFleet of 3: apply, findOutliers",
+    PI3EQX12908Sim chip1; PI3EQX12908Sim chip2; PI3EQX12908 rd1; PI3EQX12908 rd2; RedriverFleet fleet;
+    Wire.bus().attach(0x71, chip1); Wire.bus().attach(0x72, chip2);
+    rd1.init(0x71); rd2.init(0x72); fleet.add(rd); fleet.add(rd1); fleet.add(rd2);
+    rd.snapshot(state); fleet.apply(state); fleet.findOutliers();
+    Wire.bus().detach(0x71); Wire.bus().detach(0x72)),
+  SCENARIO("LinkMonitor sample()",
+    LinkMonitor monitor(rd); monitor.sample()),
+  SCENARIO("LanePowerPolicy update() powering down all lanes",
+    LanePowerPolicy policy(rd); policy.begin(); policy.setHysteresis(1, 1); policy.update()),
+  SCENARIO("SweepEngine run() on A0",
+    SweepEngine sweep(rd); sweep.run(1 << A0_SHIFT, sweep_metric)),
+  SCENARIO("SweepEngine run() on all lanes",
+    SweepEngine sweep(rd); sweep.run(SWEEP_ALL_LANES, sweep_metric)),
+  SCENARIO("SweepEngine runCoarseFine() on all lanes, step 4",
+    SweepEngine sweep(rd); sweep.runCoarseFine(SWEEP_ALL_LANES, 4, sweep_metric)),
+  SCENARIO("estimateAmplitude()",
+    uint16_t low[8]; uint16_t high[8]; rd.estimateAmplitude(low, high)),
+  SCENARIO("applyProfile()",
+    RedriverProfile profile; memset(&profile, 0, sizeof(profile)); rd.applyProfile(profile)),
+  SCENARIO("captureProfile()",
+    RedriverProfile profile; rd.captureProfile(profile)),
+  SCENARIO("writeImage_P() of a RedriverConfig",
+    static const uint8_t image[SHADOW_LEN] PROGMEM = REDRIVER_CONFIG_IMAGE(RedriverConfig().eqAll<4>().fgAll<FLAT_GAIN_00db>());
+    rd.writeImage_P(image)),
+  SCENARIO("setEQ_A0() with one NACK retried",
+    Wire.bus().failNext(1); rd.setEQ_A0(3)),
+  SCENARIO("getEQ_A0() on a stuck bus, no recovery pins",
+    Wire.bus().setStuck(9); rd.getEQ_A0(); Wire.bus().setStuck(0)),
+  SCENARIO("apply() of the current state",
+    rd.snapshot(state); rd.apply(state)),
+  SCENARIO("apply() changing EQ of A0 and A2",
+    rd.snapshot(state); state.eq[0] ^= 1; state.eq[2] ^= 1; rd.apply(state)),
+  SCENARIO("apply() changing power down and threshold",
+    rd.snapshot(state); state.power_down ^= 0x80; state.sdt ^= 1; rd.apply(state)),
+  SCENARIO("transaction of setEQ_A0, setEQ_A3, setEQ_B3",
+    rd.beginTransaction(); rd.setEQ_A0(1); rd.setEQ_A3(2); rd.setEQ_B3(3); rd.commit()),
+  SCENARIO("DriftWatchdog check() of a matching chip",
+    DriftWatchdog watchdog; uint8_t image[SHADOW_LEN]; rd.readImage(image); watchdog.add(rd, image); watchdog.check(0)),
+  SCENARIO("DriftWatchdog check() healing EQ of A0 and A2",
+    DriftWatchdog watchdog; uint8_t image[SHADOW_LEN]; rd.readImage(image); watchdog.add(rd, image);
+    image[CONFIG_A0_REG - SHADOW_FIRST_REG] ^= 0x10; image[CONFIG_A2_REG - SHADOW_FIRST_REG] ^= 0x10;
+    watchdog.setExpected(0, image); watchdog.check(0)),
+  API(setPowerDownMask(LANE_A1 | LANE_A3 | LANE_B2, CFG_OFF)),
+  API(setRxDetectConfigMask(LANES_ALL, CFG_ON)),
+  API(getSignalDetectMask(LANE_A0 | LANE_B0)),
+  SCENARIO("prefetch then 3 getters",
+    rd.prefetch(REG_BIT(CONFIG_A0_REG) | REG_BIT(CONFIG_B3_REG) | REG_BIT(SIGNAL_DET_TH_REG));
+    rd.getEQ_A0(); rd.getEQ_B3(); rd.getSDTConfig()),
+};
+
+static Result results[BENCH_MAX];
+static Result golden[BENCH_MAX];
+
+static uint16_t run_all(){
+  uint16_t count = 0;
+  for(uint8_t cached=0; cached<2; cached++){
+    for(size_t i=0; i<sizeof(BENCHES)/sizeof(BENCHES[0]); i++){
+      PI3EQX12908Sim chip;
+      PI3EQX12908_WireBus bus(Wire);
+      PI3EQX12908 rd;
+      uint8_t data[REG_DUMP_LEN];
+      RedriverState state;
+      Wire.bus().attach(0x70, chip);
+      Wire.bus().setClock(BENCH_CLOCK);
+      rd.init(0x70, bus, cached);
+
+      SimI2CStats start = Wire.bus().stats();
+      BENCHES[i].run(rd, data, state);
+
+      Result& r = results[count++];
+      snprintf(r.mode, sizeof(r.mode), "%s", cached ? "cache" : "wire");
+      snprintf(r.name, sizeof(r.name), "%s", BENCHES[i].name);
+      r.stats = Wire.bus().since(start);
+      Wire.bus().detach(0x70);
+    }
+  }
+  return count;
+}
+
+static uint16_t check_async(){
+  PI3EQX12908Sim chip;
+  PI3EQX12908_WireBus bus(Wire);
+  PI3EQX12908 rd;
+  PI3EQX12908Async op(rd);
+  uint8_t data[REG_DUMP_LEN];
+  RedriverState state;
+  uint16_t failures = 0;
+  Wire.bus().attach(0x70, chip);
+  Wire.bus().setClock(BENCH_CLOCK);
+  rd.init(0x70, bus);
+  rd.snapshot(state);
+
+  for(uint8_t kind=0; kind<3; kind++){
+    if(kind == 0)
+      op.startDumpAll(data);
+    else if(kind == 1)
+      op.startApply(state);
+    else
+      op.startSetEQ(7);
+    uint8_t steps = 0;
+    uint64_t worst = 0;
+    bool running = true;
+    while(running){
+      SimI2CStats start = Wire.bus().stats();
+      running = op.poll();
+      SimI2CStats step = Wire.bus().since(start);
+      steps++;
+      if(step.transactions > 1 || step.bus_ns > ASYNC_STEP_BUDGET_NS)
+        failures++;
+      if(step.bus_ns > worst)
+        worst = step.bus_ns;
+    }
+    printf("async %-12s %2u steps, worst step %7.2f us%s\n", kind == 0 ? "startDumpAll" : kind == 1 ? "startApply" : "startSetEQ",
+           steps, worst / 1000.0, worst > ASYNC_STEP_BUDGET_NS ? "  OVER BUDGET" : "");
+  }
+  Wire.bus().detach(0x70);
+  return failures;
+}
+
+static uint16_t load_golden(const char* path){
+  FILE* f = fopen(path, "r");
+  if(!f)
+    return 0;
+  char line[256];
+  uint16_t count = 0;
+  while(count < BENCH_MAX && fgets(line, sizeof(line), f)){
+    Result& g = golden[count];
+    unsigned long txn, bytes;
+    unsigned long long ns;
+    if(line[0] == '#' || sscanf(line, "%7s %lu %lu %llu %127[^\n]", g.mode, &txn, &bytes, &ns, g.name) != 5)
+      continue;
+    g.stats.transactions = txn;
+    g.stats.wire_bytes = bytes;
+    g.stats.bus_ns = ns;
+    count++;
+  }
+  fclose(f);
+  return count;
+}
+
+static const Result* find_golden(const Result& r, uint16_t count){
+  for(uint16_t i=0; i<count; i++)
+    if(!strcmp(golden[i].mode, r.mode) && !strcmp(golden[i].name, r.name))
+      return &golden[i];
+  return NULL;
+}
+
+static bool save_golden(const char* path, uint16_t count){
+  FILE* f = fopen(path, "w");
+  if(!f)
+    return false;
+  fprintf(f, "# mode transactions wire_bytes bus_ns api  (400 kHz, generated by bench --update)\n");
+  for(uint16_t i=0; i<count; i++)
+    fprintf(f, "%-5s %3lu %4lu %8llu %s\n", results[i].mode, (unsigned long)results[i].stats.transactions,
+            (unsigned long)results[i].stats.wire_bytes, (unsigned long long)results[i].stats.bus_ns, results[i].name);
+  fclose(f);
+  return true;
+}
+
+int main(int argc, char** argv){
+  if(argc < 2){
+    fprintf(stderr, "usage: bench <golden> [--update]\n");
+    return 2;
+  }
+  uint16_t count = run_all();
+  if(argc > 2 && !strcmp(argv[2], "--update")){
+    if(!save_golden(argv[1], count)){
+      perror(argv[1]);
+      return 1;
+    }
+    printf("%u entries written to %s\n", count, argv[1]);
+    return 0;
+  }
+
+  uint16_t golden_count = load_golden(argv[1]);
+  uint16_t failures = 0;
+  uint16_t improved = 0;
+  printf("%-5s %5s %6s %10s  %s\n", "mode", "txn", "bytes", "bus_us", "api");
+  for(uint16_t i=0; i<count; i++){
+    const Result& r = results[i];
+    const Result* g = find_golden(r, golden_count);
+    const char* verdict = "";
+    if(!g){
+      verdict = "  NEW (not in golden table)";
+      failures++;
+    }
+    else if(r.stats.transactions > g->stats.transactions || r.stats.wire_bytes > g->stats.wire_bytes || r.stats.bus_ns > g->stats.bus_ns){
+      verdict = "  REGRESSION";
+      failures++;
+    }
+    else if(r.stats.transactions < g->stats.transactions || r.stats.wire_bytes < g->stats.wire_bytes || r.stats.bus_ns < g->stats.bus_ns){
+      verdict = "  improved";
+      improved++;
+    }
+    printf("%-5s %5lu %6lu %10.2f  %s%s", r.mode, (unsigned long)r.stats.transactions,
+           (unsigned long)r.stats.wire_bytes, r.stats.micros(), r.name, verdict);
+    if(g && *verdict)
+      printf(" (golden %lu/%lu/%.2f)", (unsigned long)g->stats.transactions,
+             (unsigned long)g->stats.wire_bytes, g->stats.micros());
+    printf("\n");
+  }
+  printf("\n%u APIs, %u failed, %u improved\n\n", count, failures, improved);
+  failures += check_async();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+/*!
+ * @file pi3eqx12908_i2c.cpp
+ *
+ * Command line control of a PI3EQX12908 on a Linux i2c-dev bus.
+ *
+ *   pi3eqx12908_i2c <adapter|device> <addr> dump [raw|decoded|csv|json]
+ *   pi3eqx12908_i2c <adapter|device> <addr> eq|fg|sw|sdt|pd <value>
+ *
+ * Exits with 0 on success, 1 if the device could not be opened or a bus
+ * access failed (after the driver's retries) and 2 on a usage error.
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "PI3EQX12908A2.h"
+#include "RedriverFormat.h"
+#include "Arduino.h"
+
+static const char* bus_error(uint8_t status){
+  switch(status){
+    case BUS_ERR_TOO_LONG:   return "data too long";
+    case BUS_ERR_NACK_ADDR:  return "address not acknowledged";
+    case BUS_ERR_NACK_DATA:  return "data not acknowledged";
+    case BUS_ERR_TIMEOUT:    return "timeout";
+    case BUS_ERR_SHORT_READ: return "short read";
+    default:                 return "bus error";
+  }
+}
+
+// Reports the first failed access of the command, if any
+static int result(PI3EQX12908& RD, const char* addr){
+  if(!RD.errorCount())
+    return 0;
+  fprintf(stderr, "pi3eqx12908_i2c: %s: %s (%u)\n", addr, bus_error(RD.lastError()), RD.lastError());
+  return 1;
+}
+
+static int usage(){
+  fprintf(stderr, "usage: pi3eqx12908_i2c <adapter|device> <addr> dump [raw|decoded|csv|json]\n"
+                  "       pi3eqx12908_i2c <adapter|device> <addr> eq|fg|sw|sdt|pd <value>\n");
+  return 2;
+}
+
+int main(int argc, char** argv){
+  if(argc < 4)
+    return usage();
+
+  PI3EQX12908_LinuxBus bus;
+  bool opened = argv[1][0] == '/' ? bus.begin(argv[1]) : bus.begin(atoi(argv[1]));
+  if(!opened){
+    perror(argv[1]);
+    return 1;
+  }
+
+  PI3EQX12908 RD;
+  RD.init((uint8_t)strtoul(argv[2], NULL, 0), bus);
+
+  const char* cmd = argv[3];
+  if(!strcmp(cmd, "dump")){
+    const char* name = argc > 4 ? argv[4] : "raw";
+    uint8_t format;
+    if(!strcmp(name, "raw"))
+      format = FORMAT_RAW;
+    else if(!strcmp(name, "decoded"))
+      format = FORMAT_DECODED;
+    else if(!strcmp(name, "csv"))
+      format = FORMAT_CSV;
+    else if(!strcmp(name, "json"))
+      format = FORMAT_JSON;
+    else
+      return usage();
+    uint8_t data[REG_DUMP_LEN];
+    RD.dump_all(data);
+    if(result(RD, argv[2]))
+      return 1;
+    printRegisters(Serial, data, REG_DUMP_LEN, format);
+    return 0;
+  }
+  if(argc < 5)
+    return usage();
+
+  uint8_t value = (uint8_t)strtoul(argv[4], NULL, 0);
+  if(!strcmp(cmd, "eq"))
+    RD.setEQ(value);
+  else if(!strcmp(cmd, "fg"))
+    RD.setFG(value);
+  else if(!strcmp(cmd, "sw"))
+    RD.setSW(value);
+  else if(!strcmp(cmd, "sdt"))
+    RD.setSDTConfig(value);
+  else if(!strcmp(cmd, "pd"))
+    RD.setPowerDown(value);
+  else
+    return usage();
+  return result(RD, argv[2]);
+}
@@ -0,0 +1,536 @@
+/*!
+ * @file test.cpp
+ *
+ * Behavioural checks of the library against the simulated chip. Where
+ * bench.cpp only counts what an API costs on the bus, these checks
+ * compare the register contents of the simulated chip (and the values
+ * the driver returns) with what the API promised. Every case is run
+ * once without and once with the shadow cache.
+ *
+ *   test            run every case, exit status 1 if any check failed
+ *
+ * MIT License
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "Wire.h"
+#include "PI3EQX12908A2.h"
+#include "RedriverFleet.h"
+#include "DriftWatchdog.h"
+#include "LinkMonitor.h"
+#include "LanePowerPolicy.h"
+#include "PI3EQX12908Async.h"
+#include "SweepEngine.h"
+#include "RedriverFormat.h"
+#include "RedriverInstrument.h"
+#include "test.h"
+
+#define TEST_CLOCK 400000
+
+/*! @brief Simulated chip at 0x70 on Wire with a driver bound to it */
+struct Rig{
+  PI3EQX12908Sim      chip;
+  PI3EQX12908_WireBus bus;
+  PI3EQX12908         rd;
+
+  Rig(bool cached) : bus(Wire){
+    Wire.bus().attach(0x70, chip);
+    Wire.bus().setClock(TEST_CLOCK);
+    rd.init(0x70, bus, cached);
+  }
+  ~Rig(){
+    Wire.bus().failNext(0);
+    Wire.bus().detach(0x70);
+  }
+};
+
+typedef void (*TestFn)(bool cached);
+
+struct Test{
+  const char* name;
+  TestFn      run;
+};
+
+static void test_transaction_commit(bool cached){
+  Rig rig(cached);
+  rig.rd.beginTransaction();
+  rig.rd.setEQ_A0(5);
+  rig.rd.setSW_B3(SWING_1000mVpp);
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG) >> EQ_SHIFT, 0);
+  rig.rd.commit();
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG) >> EQ_SHIFT, 5);
+  CHECK_EQ(rig.chip.reg(CONFIG_B3_REG) & SW_MASK, SWING_1000mVpp);
+}
+
+// Without a valid shadow the clean registers between two dirty ones are
+// unknown and must not be written
+static void test_commit_failed_resync(bool cached){
+  Rig rig(cached);
+  rig.chip.poke(CONFIG_A1_REG, 0x62);
+  rig.chip.poke(CONFIG_A2_REG, 0x62);
+  rig.rd.invalidate();
+  rig.rd.setRetry(0, 0);
+  Wire.bus().failNext(1);
+  rig.rd.beginTransaction();
+  rig.rd.setConfig_A0(0x14);
+  rig.rd.setConfig_A3(0x24);
+  Wire.bus().failNext(1);
+  rig.rd.commit();
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG), 0x14);
+  CHECK_EQ(rig.chip.reg(CONFIG_A1_REG), 0x62);
+  CHECK_EQ(rig.chip.reg(CONFIG_A2_REG), 0x62);
+  CHECK_EQ(rig.chip.reg(CONFIG_A3_REG), 0x24);
+}
+
+// Full reads and shadow reloads inside a transaction must keep the pending writes
+static void test_transaction_survives_reads(bool cached){
+  Rig rig(cached);
+  uint8_t data[REG_DUMP_LEN];
+  RedriverState state;
+  rig.rd.beginTransaction();
+  rig.rd.setEQ_A0(5);
+  rig.rd.dump_all(data);
+  rig.rd.setEQ_A1(6);
+  rig.rd.snapshot(state);
+  rig.rd.setConfig_B3(0x3D);
+  rig.rd.invalidate();
+  rig.rd.setEQ_B0(7);
+  rig.rd.recover();
+  CHECK_EQ(rig.rd.getEQ_A0(), 5);
+  rig.rd.setCache(cached);
+  CHECK_EQ(rig.rd.getConfig_B3(), 0x3D);
+  rig.rd.commit();
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG) >> EQ_SHIFT, 5);
+  CHECK_EQ(rig.chip.reg(CONFIG_A1_REG) >> EQ_SHIFT, 6);
+  CHECK_EQ(rig.chip.reg(CONFIG_B0_REG) >> EQ_SHIFT, 7);
+  CHECK_EQ(rig.chip.reg(CONFIG_B3_REG), 0x3D);
+}
+
+static void test_apply(bool cached){
+  Rig rig(cached);
+  RedriverState state;
+  rig.rd.snapshot(state);
+  state.eq[2] = 9;
+  state.power_down = 0x81;
+  state.sdt = SDT_OFF_110_ON_210_mVpp;
+  rig.rd.apply(state);
+  CHECK_EQ(rig.chip.reg(CONFIG_A2_REG) >> EQ_SHIFT, 9);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x81);
+  CHECK_EQ((rig.chip.reg(SIGNAL_DET_TH_REG) & SDT_MASK) >> SDT_SHIFT, SDT_OFF_110_ON_210_mVpp);
+  uint8_t count = 0xFF;
+  CHECK_EQ(rig.rd.apply(state, &count), BUS_OK);
+  CHECK_EQ(count, 0);
+
+  // A failed read is reported, not taken for "nothing to change"; with
+  // the cache on the read is served by the shadow and the write fails
+  rig.rd.setRetry(0, 0);
+  state.eq[2] = 4;
+  Wire.bus().failNext(1);
+  CHECK(rig.rd.apply(state, &count) != BUS_OK);
+  CHECK_EQ(count, cached ? 1 : 0);
+  CHECK_EQ(rig.chip.reg(CONFIG_A2_REG) >> EQ_SHIFT, 9);
+  CHECK_EQ(rig.rd.apply(state, &count), BUS_OK);
+  CHECK_EQ(count, 1);
+  CHECK_EQ(rig.chip.reg(CONFIG_A2_REG) >> EQ_SHIFT, 4);
+}
+
+static void test_bank_setters(bool cached){
+  Rig rig(cached);
+  for(uint8_t reg=CONFIG_A0_REG; reg<=CONFIG_B3_REG; reg++)
+    rig.chip.poke(reg, 0x5A);
+  rig.rd.invalidate();
+  rig.rd.setEQ_A(3);
+  rig.rd.setFG_B(FLAT_GAIN_M4db);
+  rig.rd.setSW(SWING_1000mVpp);
+  for(uint8_t i=0; i<4; i++){
+    CHECK_EQ(rig.chip.reg(CONFIG_A0_REG + i), 0x3B);
+    CHECK_EQ(rig.chip.reg(CONFIG_B0_REG + i), 0x53);
+  }
+  // A failed read must not be written back as zeros
+  rig.rd.setCache(false);
+  Wire.bus().failNext(DEFAULT_RETRIES + 1);
+  rig.rd.setEQ(9);
+  CHECK_EQ(rig.chip.reg(CONFIG_A1_REG), 0x3B);
+  CHECK_EQ(rig.chip.reg(CONFIG_B2_REG), 0x53);
+}
+
+static_assert(Channel<BANK_A, 1>::REG == CONFIG_A1_REG && Channel<BANK_A, 1>::MASK == 0x20, "Channel<BANK_A, 1>");
+static_assert(Channel<BANK_B, 3>::REG == CONFIG_B3_REG && Channel<BANK_B, 3>::MASK == 0x08, "Channel<BANK_B, 3>");
+
+// The compile-time handle must reach the same register and lane bit as the runtime one
+static void test_channel_handles(bool cached){
+  Rig rig(cached);
+  Channel<BANK_B, 2> ch = rig.rd.channel<BANK_B, 2>();
+  ch.eq(7).gain(FLAT_GAIN_P2db).swing(SWING_1000mVpp);
+  CHECK_EQ(rig.chip.reg(CONFIG_B2_REG) >> EQ_SHIFT, 7);
+  CHECK_EQ((rig.chip.reg(CONFIG_B2_REG) & FG_MASK) >> FG_SHIFT, FLAT_GAIN_P2db);
+  CHECK_EQ(ch.getConfig(), rig.rd.channel(BANK_B, 2).getConfig());
+  ch.setPowerDown(CFG_OFF);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x04);
+  ChannelRef ref = ch;
+  CHECK(ref.getPowerDown());
+  CHECK_EQ(ref.reg(), CONFIG_B2_REG);
+}
+
+static void test_snapshot(bool cached){
+  Rig rig(cached);
+  RedriverState state;
+  rig.chip.setSignalDetect(0x5A);
+  rig.chip.poke(CONFIG_B1_REG, 0x7D);
+  rig.rd.snapshot(state);
+  CHECK_EQ(state.getSignalDetect(), 0x5A);
+  CHECK_EQ(state.getConfig_B(1), 0x7D);
+  CHECK_EQ(state.getEQ_B(1), 7);
+  CHECK_EQ(state.getFlatGain_B(1), FLAT_GAIN_P2db);
+  CHECK_EQ(state.getSW_B(1), SWING_1000mVpp);
+}
+
+static void test_prefetch(bool cached){
+  Rig rig(cached);
+  rig.chip.poke(CONFIG_A3_REG, 0x40);
+  rig.chip.setRxDetect(0x33);
+  rig.rd.prefetch(REG_BIT(RX_DETECT_REG) | REG_BIT(CONFIG_A3_REG));
+  CHECK_EQ(rig.rd.getRxDetect(), 0x33);
+  CHECK_EQ(rig.rd.getEQ_A3(), 4);
+}
+
+// A write between prefetch() and the getter must not leave the old bytes behind
+static void test_prefetch_then_write(bool cached){
+  Rig rig(cached);
+  uint8_t data[REG_COUNT];
+  rig.rd.prefetch(REG_BIT(CONFIG_A0_REG) | REG_BIT(CONFIG_B0_REG) | REG_BIT(CONFIG_B1_REG));
+  rig.rd.setConfig_A0(0x90);
+  rig.rd.setConfig_B0(0x2C);
+  rig.rd.read(REG_BIT(CONFIG_A0_REG), data);
+  CHECK_EQ(data[CONFIG_A0_REG], 0x90);
+  CHECK_EQ(rig.rd.getConfig_B0(), 0x2C);
+  // After a failed write the chip holds whatever landed, read it again
+  Wire.bus().failNext(DEFAULT_RETRIES + 1);
+  rig.rd.setConfig_B1(0x2C);
+  rig.chip.poke(CONFIG_B1_REG, 0x44);
+  CHECK_EQ(rig.rd.getConfig_B1(), 0x44);
+}
+
+// Drift behind the driver must be found on cached redrivers as well
+static void test_fleet_drift(bool cached){
+  Rig rig(cached);
+  PI3EQX12908Sim chip1;
+  PI3EQX12908Sim chip2;
+  PI3EQX12908 rd1;
+  PI3EQX12908 rd2;
+  RedriverFleet fleet;
+  RedriverState state;
+  Wire.bus().attach(0x71, chip1);
+  Wire.bus().attach(0x72, chip2);
+  rd1.init(0x71, rig.bus, cached);
+  rd2.init(0x72, rig.bus, cached);
+  fleet.add(rig.rd);
+  fleet.add(rd1);
+  fleet.add(rd2);
+  rig.rd.snapshot(state);
+  state.eq[3] = 8;
+  CHECK_EQ(fleet.apply(state), 0);
+  CHECK_EQ(fleet.compare(state), 0);
+  CHECK_EQ(fleet.findOutliers(), 0);
+  chip2.poke(CONFIG_A3_REG, 0);
+  CHECK_EQ(fleet.compare(state), 0x04);
+  CHECK_EQ(fleet.findOutliers(), 0x04);
+  Wire.bus().detach(0x71);
+  CHECK_EQ(fleet.compare(state), 0x06);
+  CHECK_EQ(fleet.findOutliers(), 0x06);
+  CHECK_EQ(fleet.apply(state), 0x02);
+  CHECK_EQ(chip2.reg(CONFIG_A3_REG) >> EQ_SHIFT, 8);
+  Wire.bus().detach(0x72);
+}
+
+static void count_event(uint8_t, uint8_t, bool, void* arg){
+  (*(uint8_t*)arg)++;
+}
+
+// Reads that reload the cache after a reset of the chip, or a failed
+// write, must not turn the reset chip into the expected config
+static void test_watchdog_reset_chip(bool cached){
+  Rig rig(cached);
+  DriftWatchdog watchdog;
+  RedriverState state;
+  uint8_t image[SHADOW_LEN];
+  rig.rd.setEQ(6);
+  rig.rd.readImage(image);
+  CHECK(!watchdog.add(rig.rd, NULL));
+  CHECK(watchdog.add(rig.rd, image));
+  CHECK_EQ(watchdog.check(0), DRIFT_NONE);
+
+  rig.chip.reset();
+  rig.rd.snapshot(state);
+  CHECK_EQ(watchdog.check(0), DRIFT_HEALED);
+  for(uint8_t reg=CONFIG_A0_REG; reg<=CONFIG_B3_REG; reg++)
+    CHECK_EQ(rig.chip.reg(reg) >> EQ_SHIFT, 6);
+  CHECK_EQ(watchdog.check(0), DRIFT_NONE);
+
+  rig.chip.reset();
+  rig.rd.setRetry(0, 0);
+  Wire.bus().failNext(1);
+  rig.rd.setSDTConfig(SDT_OFF_110_ON_210_mVpp);
+  rig.rd.getEQ_A0();
+  CHECK_EQ(watchdog.check(0), DRIFT_HEALED);
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG) >> EQ_SHIFT, 6);
+}
+
+static int32_t eq_metric(uint8_t, uint8_t config, void*){
+  return config >> EQ_SHIFT;
+}
+
+// Without the start read the lanes that are not swept must be left alone
+static void test_sweep_bus_error(bool cached){
+  Rig rig(cached);
+  SweepEngine sweep(rig.rd);
+  rig.rd.setConfig_A1(0x62);
+  rig.rd.setRetry(0, 0);
+  Wire.bus().failNext(1);
+  uint16_t points = sweep.run((1 << A0_SHIFT) | (1 << A2_SHIFT), eq_metric);
+  // With the cache the start read is served by the shadow and a write fails
+  if(!cached)
+    CHECK_EQ(points, 0);
+  CHECK(sweep.status() != BUS_OK);
+  CHECK_EQ(rig.chip.reg(CONFIG_A1_REG), 0x62);
+  CHECK_EQ(sweep.run((1 << A0_SHIFT) | (1 << A2_SHIFT), eq_metric), 128);
+  CHECK_EQ(sweep.status(), BUS_OK);
+  CHECK_EQ(rig.chip.reg(CONFIG_A0_REG) >> EQ_SHIFT, 15);
+  CHECK_EQ(rig.chip.reg(CONFIG_A2_REG) >> EQ_SHIFT, 15);
+  CHECK_EQ(rig.chip.reg(CONFIG_A1_REG), 0x62);
+}
+
+// A failed read must not clobber the threshold with zeros
+static void test_estimate_amplitude_bus_error(bool cached){
+  Rig rig(cached);
+  uint16_t low[8];
+  uint16_t high[8];
+  rig.chip.poke(SIGNAL_DET_TH_REG, 0x04);
+  rig.chip.setSignalDetect(0xF0);
+  rig.rd.setRetry(0, 0);
+  Wire.bus().failNext(1);
+  CHECK(rig.rd.estimateAmplitude(low, high) != BUS_OK);
+  CHECK_EQ(rig.chip.reg(SIGNAL_DET_TH_REG), 0x04);
+  CHECK_EQ(low[7], 0);
+  CHECK_EQ(high[7], AMPLITUDE_UNBOUNDED);
+  CHECK_EQ(rig.rd.estimateAmplitude(low, high), BUS_OK);
+  CHECK_EQ(rig.chip.reg(SIGNAL_DET_TH_REG), 0x04);
+  CHECK(low[7] > 0);
+  CHECK_EQ(high[0], 130);
+}
+
+// A failed read is not a sample of all links down
+static void test_link_monitor_bus_error(bool cached){
+  Rig rig(cached);
+  LinkMonitor monitor(rig.rd);
+  uint8_t events = 0;
+  rig.chip.setSignalDetect(0xF0);
+  rig.chip.setRxDetect(0xFF);
+  monitor.setDebounce(1);
+  monitor.setInterval(10, 80);
+  monitor.begin(count_event, &events);
+  CHECK(monitor.sample());
+  uint16_t interval = monitor.interval();
+  Wire.bus().failNext(DEFAULT_RETRIES + 1);
+  CHECK(!monitor.sample());
+  CHECK_EQ(monitor.errors(), 1);
+  CHECK_EQ(events, 0);
+  CHECK_EQ(monitor.getSignalDetect(), 0xF0);
+  CHECK_EQ(monitor.getRxDetect(), 0xFF);
+  CHECK_EQ(monitor.interval(), interval);
+  rig.chip.setSignalDetect(0x70);
+  CHECK(monitor.sample());
+  CHECK_EQ(events, 1);
+  CHECK_EQ(monitor.getSignalDetect(), 0x70);
+}
+
+// Bus errors must not look like "no receiver" nor power up foreign lanes
+static void test_lane_power_bus_error(bool cached){
+  Rig rig(cached);
+  LanePowerPolicy policy(rig.rd);
+  rig.chip.setRxDetect(0x7F);
+  rig.chip.poke(POWER_DOWN_REG, 0x80);
+  rig.rd.invalidate();
+  // Without the power state no lane is taken over; with the cache the
+  // resync fails first, then the direct read
+  Wire.bus().failNext((cached ? 2 : 1) * (DEFAULT_RETRIES + 1));
+  CHECK(policy.begin(0xF0) != BUS_OK);
+  CHECK_EQ(policy.poweredDown(), 0);
+  policy.setHysteresis(1, 1);
+  CHECK_EQ(policy.update(), 0);
+  CHECK_EQ(policy.begin(0xF0), BUS_OK);
+  CHECK_EQ(policy.poweredDown(), 0x80);
+  policy.end();
+  rig.chip.setRxDetect(0xFF);
+  rig.chip.poke(POWER_DOWN_REG, 0x01);
+  rig.rd.invalidate();
+  policy.begin(0xF0);
+  Wire.bus().failNext(DEFAULT_RETRIES + 1);
+  CHECK_EQ(policy.update(), 0);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x01);
+  rig.chip.setRxDetect(0x7F);
+  CHECK_EQ(policy.update(), 0x80);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x81);
+  CHECK_EQ(policy.poweredDown(), 0x80);
+  // The register update fails: nothing changes, the lane is retried next sample
+  rig.chip.setRxDetect(0x3F);
+  rig.rd.setCache(false);
+  rig.rd.setRetry(0, 0);
+  rig.rd.prefetch(REG_BIT(RX_DETECT_REG));
+  Wire.bus().failNext(1);
+  CHECK_EQ(policy.update(), 0);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x81);
+  CHECK_EQ(policy.poweredDown(), 0x80);
+  CHECK_EQ(policy.update(), 0x40);
+  CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0xC1);
+}
+
+// recover() restarts Wire, which must come back at the configured clock
+static void test_recover_keeps_clock(bool cached){
+  Rig rig(cached);
+  rig.bus.setClock(1000000);
+  rig.bus.setRecoveryPins(20, 21);
+  Wire.bus().attachPins(20, 21);
+  Wire.bus().setStuck(3);
+  rig.chip.poke(CONFIG_A1_REG, 0x60);
+  rig.rd.invalidate();
+  CHECK_EQ(rig.rd.getEQ_A1(), 6);
+  CHECK(!Wire.bus().stuck());
+  CHECK_EQ(Wire.bus().getClock(), 1000000);
+}
+
+// A failed async step is retried on later polls, one transaction per poll
+static void test_async_retry(bool cached){
+  Rig rig(cached);
+  PI3EQX12908Async op(rig.rd);
+  RedriverState state;
+  rig.rd.snapshot(state);
+  state.eq[5] = 12;
+  state.power_down = 0x0F;
+  for(uint8_t failing=1; failing<=DEFAULT_RETRIES + 1; failing += DEFAULT_RETRIES){
+    rig.chip.reset();
+    rig.rd.invalidate();
+    op.startApply(state);
+    CHECK(op.poll());
+    Wire.bus().failNext(failing);
+    uint32_t worst = 0;
+    bool running = true;
+    while(running){
+      SimI2CStats start = Wire.bus().stats();
+      running = op.poll();
+      uint32_t txn = Wire.bus().since(start).transactions;
+      if(txn > worst)
+        worst = txn;
+    }
+    CHECK(worst <= 1);
+    if(failing <= DEFAULT_RETRIES){
+      CHECK_EQ(op.status(), BUS_OK);
+      CHECK_EQ(rig.chip.reg(CONFIG_B1_REG) >> EQ_SHIFT, 12);
+      CHECK_EQ(rig.chip.reg(POWER_DOWN_REG), 0x0F);
+    }
+    else
+      CHECK_EQ(op.status(), BUS_ERR_NACK_DATA);
+  }
+}
+
+// Edited fields must show up in every format
+static void test_format_state(bool cached){
+  Rig rig(cached);
+  RedriverState state;
+  uint8_t data[REG_COUNT];
+  rig.rd.snapshot(state);
+  state.eq[0] = 9;
+  state.power_down = 0x81;
+  state.encode(data);
+  for(uint8_t format=FORMAT_RAW; format<=FORMAT_JSON; format++){
+    static char text[2048];
+    static char expected[2048];
+    static char stale[2048];
+    formatState(state, format, text, sizeof(text));
+    formatRegisters(data, REG_COUNT, format, expected, sizeof(expected));
+    formatRegisters(state.regs, REG_COUNT, format, stale, sizeof(stale));
+    CHECK(!strcmp(text, expected));
+    CHECK(strcmp(text, stale));
+  }
+}
+
+static void test_image(bool cached){
+  Rig rig(cached);
+  uint8_t image[SHADOW_LEN];
+  uint8_t back[SHADOW_LEN];
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    image[i] = 0x11 * i;
+  rig.rd.writeImage(image);
+  for(uint8_t i=0; i<SHADOW_LEN; i++)
+    CHECK_EQ(rig.chip.reg(SHADOW_FIRST_REG + i), image[i]);
+  rig.rd.readImage(back);
+  CHECK(!memcmp(back, image, SHADOW_LEN));
+}
+
+#ifdef PI3EQX12908_INSTRUMENT
+static const ApiStats* api_stats(const char* name){
+  for(uint16_t i=0; i<RedriverInstrument::apiCount(); i++)
+    if(!strcmp(RedriverInstrument::api(i)->name, name))
+      return RedriverInstrument::api(i);
+  return NULL;
+}
+
+static void test_instrument_apis(bool cached){
+  Rig rig(cached);
+  RedriverInstrument::reset();
+  rig.rd.init(0x70, cached);
+  for(uint8_t reg=0; reg<REG_DUMP_LEN; reg++)
+    rig.rd.regName(reg);
+  rig.rd.setEQ_A0(3);
+  rig.rd.setEQ_A0(4);
+  const ApiStats* init = api_stats("init");
+  const ApiStats* eq = api_stats("setEQ_A0");
+  CHECK(init && init->calls == 1);
+  CHECK(eq && eq->calls == 2);
+  CHECK(!api_stats("regName"));
+  CHECK(RedriverInstrument::apiCount() > 32);
+}
+#endif
+
+static const Test TESTS[] = {
+  TEST(test_transaction_commit),
+  TEST(test_transaction_survives_reads),
+  TEST(test_commit_failed_resync),
+  TEST(test_apply),
+  TEST(test_bank_setters),
+  TEST(test_channel_handles),
+  TEST(test_snapshot),
+  TEST(test_prefetch),
+  TEST(test_prefetch_then_write),
+  TEST(test_image),
+  TEST(test_format_state),
+  TEST(test_fleet_drift),
+  TEST(test_watchdog_reset_chip),
+  TEST(test_sweep_bus_error),
+  TEST(test_estimate_amplitude_bus_error),
+  TEST(test_link_monitor_bus_error),
+  TEST(test_lane_power_bus_error),
+  TEST(test_recover_keeps_clock),
+  TEST(test_async_retry),
+#ifdef PI3EQX12908_INSTRUMENT
+  TEST(test_instrument_apis),
+#endif
+};
+
+int main(){
+  uint16_t failed = 0;
+  for(uint8_t cached=0; cached<2; cached++){
+    for(size_t i=0; i<sizeof(TESTS)/sizeof(TESTS[0]); i++){
+      uint16_t before = failures;
+      TESTS[i].run(cached);
+      bool ok = failures == before;
+      if(!ok)
+        failed++;
+      printf("%-5s %-4s %s\n", cached ? "cache" : "wire", ok ? "ok" : "FAIL", TESTS[i].name);
+    }
+  }
+  printf("\n%u checks, %u failed, %u cases failed\n", checks, failures, failed);
+  return failures ? 1 : 0;
+}
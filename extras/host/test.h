@@ -0,0 +1,41 @@
+/*!
+ * @file test.h
+ *
+ * Check macros shared by the host test programs (test.cpp and
+ * test_linux.cpp). A failed check prints its line and expression and is
+ * counted; the program decides the exit status from the counters.
+ *
+ * MIT License
+ *
+ */
+
+#ifndef _HOST_TEST_H
+#define _HOST_TEST_H
+
+#include <stdio.h>
+
+static uint16_t checks;
+static uint16_t failures;
+
+#define CHECK(cond) check((cond), #cond, __LINE__)
+#define CHECK_EQ(a, b) check_eq((a), (b), #a, #b, __LINE__)
+
+static void check(bool ok, const char* expr, int line){
+  checks++;
+  if(ok)
+    return;
+  failures++;
+  printf("    line %d: %s\n", line, expr);
+}
+
+static void check_eq(unsigned a, unsigned b, const char* expr_a, const char* expr_b, int line){
+  checks++;
+  if(a == b)
+    return;
+  failures++;
+  printf("    line %d: %s == %s (0x%02X != 0x%02X)\n", line, expr_a, expr_b, a, b);
+}
+
+#define TEST(fn) { #fn, fn } ///< Table entry of a test function
+
+#endif
@@ -0,0 +1,137 @@
+/*!
+ * @file test_linux.cpp
+ *
+ * Checks of the Linux i2c-dev transport and of the pi3eqx12908_i2c tool
+ * against a fake adapter. This program defines ioctl(), so the I2C_RDWR
+ * calls of PI3EQX12908_LinuxBus land on a simulated bus with a
+ * PI3EQX12908Sim at 0x70 instead of the kernel; the device file itself
+ * is /dev/null. The tool is linked in with its main() renamed to
+ * pi3eqx12908_i2c_main (see the Makefile).
+ *
+ *   test_linux      run every case, exit status 1 if any check failed
+ *
+ * MIT License
+ *
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <string.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "PI3EQX12908A2.h"
+#include "PI3EQX12908Sim.h"
+#include "test.h"
+
+#define FAKE_DEVICE "/dev/null"
+
+int pi3eqx12908_i2c_main(int argc, char** argv);
+
+static SimI2CBus      fake_bus;
+static PI3EQX12908Sim chip;
+
+// Fake adapter: I2C_RDWR messages go to fake_bus, errors come back as the
+// errno values the kernel drivers use
+extern "C" int ioctl(int fd, unsigned long request, ...){
+  (void)fd;
+  if(request != I2C_RDWR){
+    errno = ENOTTY;
+    return -1;
+  }
+  va_list args;
+  va_start(args, request);
+  struct i2c_rdwr_ioctl_data* xfer = va_arg(args, struct i2c_rdwr_ioctl_data*);
+  va_end(args);
+  for(uint32_t i=0; i<xfer->nmsgs; i++){
+    struct i2c_msg& msg = xfer->msgs[i];
+    uint8_t status = msg.flags & I2C_M_RD ? fake_bus.read(msg.addr, msg.buf, msg.len)
+                                          : fake_bus.write(msg.addr, msg.buf, msg.len);
+    switch(status){
+      case BUS_OK:            continue;
+      case BUS_ERR_NACK_ADDR: errno = ENXIO; break;
+      case BUS_ERR_TIMEOUT:   errno = ETIMEDOUT; break;
+      default:                errno = EIO; break;
+    }
+    return -1;
+  }
+  return xfer->nmsgs;
+}
+
+typedef void (*TestFn)();
+
+struct Test{
+  const char* name;
+  TestFn      run;
+};
+
+static int run_tool(const char* addr, const char* cmd, const char* value){
+  char* argv[] = {(char*)"pi3eqx12908_i2c", (char*)FAKE_DEVICE, (char*)addr, (char*)cmd, (char*)value, NULL};
+  return pi3eqx12908_i2c_main(value ? 5 : 4, argv);
+}
+
+static void test_read_write(){
+  PI3EQX12908_LinuxBus bus;
+  PI3EQX12908 rd;
+  CHECK(bus.begin(FAKE_DEVICE));
+  rd.init(0x70, bus);
+  rd.setEQ_A2(11);
+  CHECK_EQ(chip.reg(CONFIG_A2_REG) >> EQ_SHIFT, 11);
+  chip.poke(CONFIG_B1_REG, 0x6C);
+  CHECK_EQ(rd.getConfig_B1(), 0x6C);
+  CHECK_EQ(rd.errorCount(), 0);
+}
+
+static void test_errors(){
+  PI3EQX12908_LinuxBus bus;
+  PI3EQX12908 rd;
+  rd.init(0x70, bus);
+  rd.setRetry(0, 0);
+  rd.getEQ_A0();
+  CHECK_EQ(rd.lastError(), BUS_ERR_OTHER);
+  CHECK(bus.begin(FAKE_DEVICE));
+  rd.init(0x71, bus);
+  rd.setRetry(0, 0);
+  rd.getEQ_A0();
+  CHECK_EQ(rd.lastError(), BUS_ERR_NACK_ADDR);
+  rd.init(0x70, bus);
+  rd.setRetry(0, 0);
+  fake_bus.failNext(1, BUS_ERR_TIMEOUT);
+  rd.setConfig_A0(0x12);
+  CHECK_EQ(rd.lastError(), BUS_ERR_TIMEOUT);
+}
+
+static void test_tool_exit_status(){
+  CHECK_EQ(run_tool("0x70", "eq", "6"), 0);
+  for(uint8_t reg=CONFIG_A0_REG; reg<=CONFIG_B3_REG; reg++)
+    CHECK_EQ(chip.reg(reg) >> EQ_SHIFT, 6);
+  CHECK_EQ(run_tool("0x70", "dump", "csv"), 0);
+  CHECK_EQ(run_tool("0x71", "dump", NULL), 1);
+  CHECK_EQ(run_tool("0x71", "pd", "1"), 1);
+  fake_bus.failNext(DEFAULT_RETRIES + 1);
+  CHECK_EQ(run_tool("0x70", "sdt", "2"), 1);
+  CHECK_EQ(run_tool("0x70", "bogus", "1"), 2);
+  CHECK_EQ(run_tool("0x70", "dump", "xml"), 2);
+}
+
+static const Test TESTS[] = {
+  TEST(test_read_write),
+  TEST(test_errors),
+  TEST(test_tool_exit_status),
+};
+
+int main(){
+  uint16_t failed = 0;
+  fake_bus.attach(0x70, chip);
+  for(size_t i=0; i<sizeof(TESTS)/sizeof(TESTS[0]); i++){
+    uint16_t before = failures;
+    chip.reset();
+    fake_bus.failNext(0);
+    TESTS[i].run();
+    bool ok = failures == before;
+    if(!ok)
+      failed++;
+    printf("%-4s %s\n", ok ? "ok" : "FAIL", TESTS[i].name);
+  }
+  printf("\n%u checks, %u failed, %u cases failed\n", checks, failures, failed);
+  return failures ? 1 : 0;
+}